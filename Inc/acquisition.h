@@ -0,0 +1,62 @@
+#pragma once
+
+#include "stm32f4xx_hal.h"
+#include "relay_numeric.h"
+
+// One power cycle of samples, one row per channel in rank order
+typedef struct {
+    sample_t (*samples)[sample_times];
+} cycleSamples;
+
+// One scan, a sample of every channel taken on the same trigger
+typedef struct {
+    sample_t value[ADC_CHANNELS];
+    // Scans were lost before this one, it is the first of a cycle and the sliding state starts over
+    bool resync;
+} scanSample;
+
+// Triggers per power cycle, RELAY_OVERSAMPLE of them are decimated into each sample
+#define TRIGGERS_PER_CYCLE (sample_times * RELAY_OVERSAMPLE)
+
+// Trigger timer ticks per 1MHz tick, finer when oversampling so the short reloads still
+// land close to the period. 21MHz keeps a 40Hz cycle of 12 scans inside 16 bits
+#if RELAY_OVERSAMPLE > 1
+#define TRIGGER_TICKS_PER_US 21
+#else
+#define TRIGGER_TICKS_PER_US 1
+#endif
+
+// Trigger timer reload for a cycle of period 1MHz ticks, the timer counts ARR + 1 ticks
+#define SAMPLE_RELOAD(period) ((((period) * TRIGGER_TICKS_PER_US + TRIGGERS_PER_CYCLE/2) / TRIGGERS_PER_CYCLE) - 1)
+
+// The 1MHz ticks a cycle of triggers takes at a reload
+#define TRIGGER_WINDOW(reload) ((float)TRIGGERS_PER_CYCLE * ((reload) + 1) / TRIGGER_TICKS_PER_US)
+
+// The 1MHz ticks for one cycle, tracked from the zero crossings and the VA phasor
+extern volatile uint32_t g_current_period;
+
+// Cycles the main loop was too slow to pick up
+extern volatile uint32_t missed_cycles;
+
+// Scans a reader lost to an overrun restart or to the DMA lapping it, summed over the readers
+extern volatile uint32_t dropped_scans;
+
+void adc_init(void);
+
+void pll_init(void);
+
+void timer_init(void);
+
+void acquisition_start(void);
+
+bool takeCycle(cycleSamples *cycle);
+
+bool takeScan(scanSample *scan);
+
+#if RELAY_INSTANT && RELAY_ACQ == RELAY_ACQ_DMA
+// Hand the scans the DMA wrote since the last call to the instantaneous element
+void instantPoll(void);
+#else
+// The ADC interrupt feeds it every scan already
+static inline void instantPoll(void){}
+#endif
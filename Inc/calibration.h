@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "relay_config.h"
+#include "relay_numeric.h"
+#include "dft.h"
+
+// Per channel calibration of the analog front end, the CT or VT, its burden and the ADC
+// The interrupts only move raw codes, the correction is one complex multiply on every
+// phasor where a sample by sample one would be a multiply per conversion and could not
+// turn the angle at all. Gain and phase make up the factor, the offset has nothing to do
+// there as the correlation rejects a constant exactly, it seeds the instantaneous
+// element's offset average instead of mid rail. The instantaneous element works on the
+// raw codes, its pickup is divided by the gain of each phase instead
+
+typedef struct {
+    float gain;         // True over measured magnitude, multiplied into the phasor
+    float phase_deg;    // True minus measured angle, added to the phasor
+    float offset_v;     // Front end bias at the pin
+} channelCalibration;
+
+#if RELAY_CALIBRATION
+
+// The figures of this board, in flash with the code
+extern const channelCalibration channel_calibration[ADC_CHANNELS];
+
+// gain e^(j phase) of a channel in the numeric mode
+typedef struct {
+#if RELAY_NUMERIC == RELAY_NUMERIC_FIXED
+    int32_t real;   // Q14, a gain up to 2
+    int32_t img;
+#else
+    real_t real;
+    real_t img;
+#endif
+} calibrationFactor;
+
+#define CALIBRATION_SHIFT 14
+
+extern calibrationFactor calibration_factor[ADC_CHANNELS];
+
+// Compile the flash figures into the factors, before the acquisition starts
+void calibration_init(void);
+
+static inline complexNum calibrate(complexNum value, const calibrationFactor *factor){
+    complexNum out;
+#if RELAY_NUMERIC == RELAY_NUMERIC_FIXED
+    out.real = (phasor_t)(((int64_t)value.real * factor->real - (int64_t)value.img * factor->img) >> CALIBRATION_SHIFT);
+    out.img = (phasor_t)(((int64_t)value.real * factor->img + (int64_t)value.img * factor->real) >> CALIBRATION_SHIFT);
+#else
+    out.real = value.real * factor->real - value.img * factor->img;
+    out.img = value.real * factor->img + value.img * factor->real;
+#endif
+    return out;
+}
+
+// Every channel's phasor in rank order, in place
+static inline void calibratePhasors(complexNum *phasors){
+    for(int ch = 0; ch < ADC_CHANNELS; ch++){
+        phasors[ch] = calibrate(phasors[ch], &calibration_factor[ch]);
+    }
+}
+
+// Several phasors of one channel, its harmonics
+static inline void calibrateChannel(int channel, complexNum *values, int count){
+    for(int i = 0; i < count; i++){
+        values[i] = calibrate(values[i], &calibration_factor[channel]);
+    }
+}
+
+static inline double calibrationGain(int channel){ return channel_calibration[channel].gain; }
+
+static inline double calibrationOffset(int channel){ return channel_calibration[channel].offset_v; }
+
+#else
+
+static inline void calibration_init(void){}
+
+static inline void calibratePhasors(complexNum *phasors){ (void)phasors; }
+
+static inline void calibrateChannel(int channel, complexNum *values, int count){ (void)channel; (void)values; (void)count; }
+
+static inline double calibrationGain(int channel){ (void)channel; return 1.0; }
+
+static inline double calibrationOffset(int channel){ (void)channel; return ADC_VREF / 2.0; }
+
+#endif
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "relay_numeric.h"
+
+// Westinghouse CO curves, the trip time in ms at the base time dial is
+// T + K/(M-C)^P at or above 1.5 PSM and R/(M-1) below it
+// TR is the disc reset time in ms from full travel at zero current, the tr of the US
+// curve each one is modelled on, U5 short time inverse for CO2, U1 moderately, U2 plain,
+// U3 very and U4 extremely inverse for CO7 to CO11. CO5 and CO6, the long time and the
+// definite minimum, have no US curve, their 0 resets the progress at once instead of
+// winding it back like a disc
+//          name  T        K         C      P  R      TR
+#define CO_CURVES(X) \
+    X(CO2,   111.99,  735.00,   0.675, 1, 501,   323)  \
+    X(CO5,   8196.67, 13768.94, 1.130, 1, 22705, 0)    \
+    X(CO6,   784.52,  671.01,   1.190, 1, 1475,  0)    \
+    X(CO7,   524.84,  3120.56,  0.800, 1, 2491,  1080) \
+    X(CO8,   477.84,  4122.08,  1.270, 1, 9200,  5950) \
+    X(CO9,   310.01,  2756.06,  1.350, 1, 9342,  3880) \
+    X(CO11,  110.00,  17640.00, 0.500, 2, 8875,  5670)
+
+// IEC 60255-151 inverse curves, the trip time in s at TMS 1 is K/(M^A - 1)
+// and the reset time TR/(1 - M^2)
+//          name  K      A     TR
+#define IEC_CURVES(X) \
+    X(IEC_SI,  0.14,  0.02, 13.5)  \
+    X(IEC_VI,  13.5,  1,    47.3)  \
+    X(IEC_EI,  80.0,  2,    80.0)  \
+    X(IEC_LTI, 120.0, 1,    120.0)
+
+// IEEE C37.112 inverse curves, the trip time in s at TD 1 is A/(M^P - 1) + B
+// and the reset time TR/(1 - M^2)
+//           name  A       B       P     TR
+#define IEEE_CURVES(X) \
+    X(IEEE_MI, 0.0515, 0.1140, 0.02, 4.85) \
+    X(IEEE_VI, 19.61,  0.4910, 2,    21.6) \
+    X(IEEE_EI, 28.2,   0.1217, 2,    29.1)
+
+#define CURVE_ENUM(name, ...) name,
+
+typedef enum {
+    CO_CURVES(CURVE_ENUM)
+    IEC_CURVES(CURVE_ENUM)
+    IEEE_CURVES(CURVE_ENUM)
+    CURVE_COUNT
+} Curves;
+
+// Shape of the curve equation, selects the evaluator
+typedef enum {
+    FORM_CO,        // T + K/(M-C)^P, R/(M-1) below 1.5 PSM
+    FORM_INVERSE,   // T + K/(M^P - 1), the IEC and IEEE curves
+} curveForm;
+
+// The curves are tabulated at this time dial, other settings scale linearly
+// so time_delay / CURVE_BASE_DELAY is the TMS of the IEC and the TD of the IEEE curves
+#define CURVE_BASE_DELAY 24000.0
+
+// Progress table points, semi-log in PSM squared from 1 up to the saturation point
+#include "psm_breakpoints.h"
+#define CURVE_POINTS (PSM2_OCTAVES * PSM2_STEPS + 1)
+
+// Reset table points, even steps in PSM squared from 0 up to pickup
+#define RESET_POINTS (PSM2_STEPS + 1)
+
+// A row holds the operate points and then the reset points, so one pointer selects both
+#define CURVE_ROW (CURVE_POINTS + RESET_POINTS)
+
+// Reset rate of a curve that has no reset time, the progress goes straight back to 0
+#if RELAY_NUMERIC == RELAY_NUMERIC_FIXED
+#define RESET_INSTANT ((rate_t)UINT32_MAX)
+#else
+#define RESET_INSTANT ((rate_t)-1)
+#endif
+
+typedef struct {
+    double time_delay;
+    double current_pickup;
+    Curves type;
+    double direction_angle;
+    double residual_pickup;
+    double instant_pickup;      // Instantaneous element, RMS volts at the pin like current_pickup
+    uint8_t instant_count;      // Scans over instant_pickup before it trips
+    double harmonic_restraint;  // Second harmonic over the fundamental that holds the time elements, 0 is off
+}relayType;
+
+// Coefficients in seconds at the base time dial, constC and constR are only used by the CO form
+typedef struct {
+    curveForm form;
+    double constT;
+    double constK;
+    double constC;
+    double constP;
+    double constR;
+    double constTR;     // Reset time from full travel, 0 resets at once
+}constTable;
+
+// Coefficients of every curve, indexed by Curves
+extern const constTable ktable[CURVE_COUNT];
+
+// Progress per second at the base time dial, built by the compiler into flash
+// The reset points are the rate the progress winds back at below pickup
+extern const rate_t curveRates[CURVE_COUNT][CURVE_ROW];
+
+rate_t curveLookup(const rate_t *table, psm2_t psm2);
+
+rate_t resetLookup(const rate_t *table, psm2_t psm2);
+
+double getTime(const relayType *curRelay, double current_PSM);
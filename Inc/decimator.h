@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "relay_config.h"
+
+// Decimation of the oversampled conversions into the samples of the protection
+// The trigger runs RELAY_OVERSAMPLE times faster than the protection needs, every channel
+// at 12 bit, and the DMA collects each burst of that many scans. A second order CIC sums
+// them, two integrators on every conversion and two combs once a burst, into one sample
+// of ADC_BITS. Its response is a squared sinc with a null on every multiple of the
+// protection rate, so what would fold onto the fundamental and its harmonics there is
+// taken out before the rate drops instead of aliased in. The passband droop at the
+// fundamental is scaled back in the same step, the trigger tracks the frequency so the
+// fundamental always sits at the same place in the response. Harmonics droop a bit more,
+// the restraint setting is brought down to what the bank reads of the second
+
+#if RELAY_OVERSAMPLE > 1
+
+// Scale for the droop, before the acquisition starts
+void decimator_init(void);
+
+// RELAY_OVERSAMPLE raw scans in rank order to one scan of ADC_BITS codes, from the DMA interrupt
+void decimatorBurst(const uint16_t *burst, uint16_t *scan);
+
+// Response at a harmonic over the one at the fundamental, what the bank has to take out
+double decimatorRelative(int harmonic);
+
+#else
+
+static inline void decimator_init(void){}
+
+static inline double decimatorRelative(int harmonic){ (void)harmonic; return 1.0; }
+
+#endif
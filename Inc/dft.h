@@ -0,0 +1,42 @@
+#pragma once
+
+#include "relay_numeric.h"
+
+typedef struct {
+    phasor_t real;
+    phasor_t img;
+} complexNum;
+
+// State of the recursive sliding DFT of every channel, one row per channel
+typedef struct {
+    sample_t window[ADC_CHANNELS][sample_times];  // The last cycle of samples
+    acc_t real[ADC_CHANNELS];                     // Running correlation over the window
+    acc_t img[ADC_CHANNELS];
+    acc_t anchor_real[ADC_CHANNELS];              // Correlation of the current cycle so far
+    acc_t anchor_img[ADC_CHANNELS];
+    uint8_t index;                                // Twiddle index of the next scan
+} slidingBank;
+
+// Twiddles in flash, the cosine is the sine a quarter cycle later
+extern const twiddle_t trig_table[sample_times + sample_times/4];
+#define SIN_TABLE (&trig_table[0])
+#define COS_TABLE (&trig_table[sample_times/4])
+
+complexNum getFiltered(sample_t *adc_data, const twiddle_t *cos_table, const twiddle_t *sin_table);
+
+void getFilteredBank(sample_t (*samples)[sample_times], complexNum *phasors, const twiddle_t *cos_table, const twiddle_t *sin_table);
+
+void slidingReset(slidingBank *bank);
+
+void slidingUpdate(slidingBank *bank, const sample_t *scan, complexNum *phasors, const twiddle_t *cos_table, const twiddle_t *sin_table);
+
+#if RELAY_HARMONIC
+
+// Harmonics 2 to HARMONIC_MAX, row h - 2 of a harmonic table
+#define HARMONICS (HARMONIC_MAX - 1)
+
+// Every harmonic of every channel over one cycle in a single pass, each sample is loaded
+// once for all harmonics. The rows hold the twiddles of one harmonic each
+void getHarmonicBank(sample_t (*samples)[sample_times], complexNum (*harmonics)[HARMONICS], const twiddle_t (*cos_rows)[sample_times], const twiddle_t (*sin_rows)[sample_times]);
+
+#endif
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "relay_config.h"
+#include "relay_numeric.h"
+#include "dft.h"
+#include "settings.h"
+
+// Directional decision of the elements, the sign of the torque between the polarizing
+// voltage and the current turned by the torque angle
+// A close-in fault collapses the voltage a phase element polarizes on and leaves its
+// direction to noise. With RELAY_MEMORY the whole cycle voltages are kept once a power
+// cycle in a short ring while they are healthy and nothing is picked up, and every entry
+// is turned by the rotation the tracked frequency gives the phasors over a cycle. When
+// the measured voltage falls below MEMORY_MIN_VOLTS the oldest entry polarizes instead,
+// so the first decision after the fault already has a direction. After MEMORY_CYCLES
+// without a refresh the memory is dropped and the direction last found on it is held
+// until the element drops out. The residual element polarizes on -3V0, which only shows
+// up in a fault, so it never uses the memory
+
+// What polarized a decision, in the element flags of the telemetry
+typedef enum {
+    POLAR_MEASURED,     // The voltage of the element itself
+    POLAR_MEMORY,       // Collapsed, the remembered voltage turned up to now
+    POLAR_HELD,         // Collapsed past the memory, the direction found on it is kept
+    POLAR_NONE,         // Collapsed with nothing remembered, never forward
+} polarSource;
+
+typedef struct {
+    uint32_t stored;        // Phase cycles written into the memory
+    uint32_t memory;        // Decisions polarized by the memory
+    uint32_t held;          // Decisions on a held direction
+    uint32_t blocked;       // Decisions with the voltage collapsed and nothing to go on
+} directionalStats;
+
+extern directionalStats directional_stats;
+
+bool isForward(complexNum voltage, complexNum current, twiddle_t C_setting, twiddle_t S_setting);
+
+// Direction of the picked up phase element e, source tells what polarized it
+bool phaseForward(int e, complexNum voltage, complexNum current, const compiledSettings *settings, polarSource *source);
+
+#if RELAY_MEMORY
+
+void directional_init(void);
+
+// Once a power cycle with the phase voltages of the cycle just ended, in element order
+// quiet says nothing was picked up during it
+void directionalCycle(const complexNum *voltages, bool quiet);
+
+// Phase element e dropped out, a held direction goes with it
+void directionalDropout(int e);
+
+#else
+
+static inline void directional_init(void){}
+
+static inline void directionalCycle(const complexNum *voltages, bool quiet){ (void)voltages; (void)quiet; }
+
+static inline void directionalDropout(int e){ (void)e; }
+
+#endif
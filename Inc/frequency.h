@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "relay_config.h"
+#include "dft.h"
+
+// Frequency tracking of the sampling, the trigger timer is kept at sample_times scans a cycle
+// The zero crossings are timestamped on the 32 bit TIM2 at the full 84MHz and averaged
+// over FREQUENCY_AVERAGE good periods, crossings that do not fit the average are dropped.
+// Once a cycle the rotation of the VA phasor gives a second estimate, it is used instead
+// of the crossings when they disagree and when the comparator goes quiet
+
+// Ticks of the capture timer per microsecond, TIM2 runs without a prescaler
+#define CAPTURE_TICKS_PER_US 84
+
+// Zero crossing periods averaged, a power of two
+#define FREQUENCY_AVERAGE 4
+
+// Where the period came from, see freq_tracker
+typedef enum {
+    FREQ_HOLD,      // Neither estimate is usable, the last period is kept
+    FREQ_CAPTURE,   // Averaged zero crossings
+    FREQ_PHASOR,    // Rotation of the voltage phasor from one cycle to the next
+} frequencySource;
+
+typedef struct {
+    uint32_t period_q8;         // Tracked period in 1MHz ticks, Q24.8
+    uint8_t source;             // frequencySource of the last update
+    uint32_t capture_rejects;   // Crossings dropped as noise or as gaps
+    uint32_t disagreements;     // Cycles the crossings and the phasor did not agree on
+    uint32_t fallbacks;         // Cycles tracked without the comparator
+} frequencyTracker;
+
+// Read with the debugger, the telemetry carries the source
+extern frequencyTracker freq_tracker;
+
+// A rising edge of the comparator, from the capture interrupt
+void frequencyCapture(uint32_t stamp);
+
+// Once per cycle from the main loop with the full cycle phasor of VA
+// Picks the estimate and retunes the trigger timer
+void frequencyCycle(const complexNum *voltage);
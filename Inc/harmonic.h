@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "relay_config.h"
+#include "relay_numeric.h"
+#include "dft.h"
+
+// Harmonic phasors and the second harmonic restraint of the inverse time elements
+// Once a power cycle, on the same window the fundamental of that cycle comes from,
+// harmonics 2 to HARMONIC_MAX of every channel are computed in one pass. Energising a
+// transformer draws an inrush rich in second harmonic that can stay above pickup for
+// many cycles. While any phase current above pickup carries more second harmonic than
+// the setting, relative to its own fundamental, every time element holds its progress,
+// one phase restrains them all. The instantaneous element is never restrained, and the
+// first cycle of an inrush is not either, the window has to hold a whole cycle of it
+
+// Second harmonic over the fundamental, squared so neither side needs a root
+typedef struct {
+#if RELAY_NUMERIC == RELAY_NUMERIC_FIXED
+    uint32_t ratio2;    // Q16, 0 turns the restraint off
+#else
+    real_t ratio2;
+#endif
+} restraintSetting;
+
+typedef struct {
+    uint32_t restrained;    // Cycles the time elements were held
+} harmonicStats;
+
+#if RELAY_HARMONIC
+
+extern harmonicStats harmonic_stats;
+
+// The bank of the last cycle in peak units of the phasors, row h - 2 is harmonic h
+// Oversampled still with the decimator's droop relative to the fundamental
+extern complexNum harmonics[ADC_CHANNELS][HARMONICS];
+
+// Ratio of the RMS of the second harmonic to the fundamental, 0.15 is the usual setting
+restraintSetting restraintCompile(double ratio);
+
+void harmonic_init(void);
+
+// A whole cycle is in samples and its fundamental in phasors, before its decision
+// Fills the bank and decides the restraint of the decisions until the next cycle
+void harmonicCycle(sample_t (*samples)[sample_times], const complexNum *phasors);
+
+bool harmonicRestrained(void);
+
+#else
+
+static inline restraintSetting restraintCompile(double ratio){ (void)ratio; return (restraintSetting){ 0 }; }
+
+static inline void harmonic_init(void){}
+
+static inline void harmonicCycle(sample_t (*samples)[sample_times], const complexNum *phasors){ (void)samples; (void)phasors; }
+
+static inline bool harmonicRestrained(void){ return false; }
+
+#endif
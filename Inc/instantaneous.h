@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "relay_config.h"
+
+// Instantaneous overcurrent (50), a high set on the raw phase current samples
+// Runs on every scan as it arrives, from the ADC interrupt in IT mode or from
+// instantPoll() on the DMA counter, so a close-in fault trips well inside the
+// cycle the DFT needs. Non-directional, set it above the largest reverse fault
+// current. The front end offset is a slow average of the codes from the calibrated bias
+// on, held while picked up.
+// No estimator here rejects a decaying DC offset, a fully offset fault overreaches
+// by up to twice, so set the pickup with that margin
+
+// Pickup in the units of the estimator for each phase, through its calibrated gain,
+// and the scans over it before tripping
+typedef struct {
+    uint64_t threshold[RELAY_PHASES];
+    uint8_t security;
+} instantSetting;
+
+typedef struct {
+    uint32_t operations;    // Trips the element gave
+    uint32_t pickups;       // Scans over the pickup
+} instantStats;
+
+#if RELAY_INSTANT
+
+extern instantStats instant_stats;
+
+// Pickup in RMS volts at the pin like current_pickup, count is the scans over it before tripping
+instantSetting instantCompile(double pickup, uint8_t count);
+
+void instant_init(void);
+
+// One scan of raw codes in rank order, against the setting of the active bank
+void instantScan(const uint16_t *raw);
+
+// Operated and the current has not been below pickup for a whole cycle since
+bool instantActive(void);
+
+// Scans were lost before the next one, the look back and the count over pickup start over
+void instantGap(void);
+
+#else
+
+static inline instantSetting instantCompile(double pickup, uint8_t count){ (void)pickup; (void)count; return (instantSetting){ { 0 }, 0 }; }
+
+static inline void instant_init(void){}
+
+static inline void instantScan(const uint16_t *raw){ (void)raw; }
+
+static inline bool instantActive(void){ return false; }
+
+#endif
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "relay_config.h"
+
+// Pipeline latency probes on the DWT cycle counter
+// Every stage is timed from the acquisition event of the data it works on, read
+// latency_stats with the debugger. The trip is timed from the end of conversion of the
+// newest scan instead, the whole way from the last sample to the pin, and its worst case
+// goes out with the telemetry. With RELAY_PROFILE off the probes compile to nothing
+
+typedef enum {
+    LAT_ADC_ISR,    // ADC interrupt or DMA half/full transfer entry, the origin of the others
+    LAT_BUFFER,     // Main loop picked up the cycle or the scan
+    LAT_PHASOR,     // Phasors of every channel are ready
+    LAT_DECISION,   // Every element has been evaluated
+    LAT_TRIP,       // quickTrip drove the output, from the end of conversion of the newest scan
+    LAT_STAGES
+} latencyStage;
+
+// Power of two buckets, bucket b holds latencies of [2^(b-1), 2^b) cycles
+#define LATENCY_BINS 24
+
+typedef struct {
+    uint32_t min;
+    uint32_t max;
+    uint32_t count;
+    uint32_t histogram[LATENCY_BINS];
+} latencyStats;
+
+#if RELAY_PROFILE
+
+#ifdef RELAY_HOST
+// No DWT on the host, the simulation supplies the count on its own clock
+uint32_t hostCycles(void);
+// The work that ends at a probe, a simulation charges it to that clock
+void hostStage(latencyStage stage);
+#define CYCLE_COUNT() hostCycles()
+#else
+#define CYCLE_COUNT() (DWT->CYCCNT)
+#endif
+
+extern latencyStats latency_stats[LAT_STAGES];
+
+// Decisions that came later than one step (a sample when sliding, a cycle otherwise) after their data
+extern uint32_t latency_overruns;
+
+void latency_init(void);
+
+void latencyMark(latencyStage stage);
+
+// End of a scan the DMA moved without an event of its own, from the ADC interrupt
+void latencyScan(void);
+
+// Worst LAT_TRIP since the last reset in microseconds rounded up, 0 before the first trip
+uint32_t latencyTripWorst(void);
+
+void latencyReset(void);
+
+#else
+
+static inline void latency_init(void){}
+
+static inline void latencyMark(latencyStage stage){ (void)stage; }
+
+static inline void latencyScan(void){}
+
+static inline uint32_t latencyTripWorst(void){ return 0; }
+
+static inline void latencyReset(void){}
+
+#endif
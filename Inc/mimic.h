@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "relay_config.h"
+#include "relay_numeric.h"
+
+// Digital mimic filter ahead of the DFT, takes the decaying DC offset out of the samples
+// y[n] = K ((1 + tau) x[n] - tau x[n-1]) with tau the offset's time constant in samples,
+// a zero on the offset's pole so an exponential of that time constant is cancelled
+// outright and one near it mostly. K brings the fundamental back to unit gain. Every
+// channel goes through it, so the voltages get the same phase shift as the currents and
+// the direction does not move. The harmonic bank takes the rest of the response out of
+// its twiddle rows. The price is high frequency gain, about 4 at Nyquist for 40 ms
+
+typedef struct {
+#if RELAY_NUMERIC == RELAY_NUMERIC_FIXED
+    int32_t b0;     // Q14, about 10 for 40 ms at 64 samples
+    int32_t b1;
+#else
+    real_t b0;
+    real_t b1;
+#endif
+    double tau;     // Samples
+} mimicFilter;
+
+#define MIMIC_SHIFT 14
+
+// Coefficients for an offset of tau_ms on a cycle of period_us ticks
+void mimicDesign(mimicFilter *filter, double tau_ms, uint32_t period_us);
+
+// Response at a harmonic over the one at the fundamental, what the bank has to take out
+void mimicRelative(const mimicFilter *filter, int harmonic, double *real, double *img);
+
+// One sample through the filter, last is the input before it
+static inline sample_t mimicStep(const mimicFilter *filter, sample_t x, sample_t last){
+#if RELAY_NUMERIC == RELAY_NUMERIC_FIXED
+    // The gain above the fundamental takes an oversampled full scale step past 16 bits,
+    // and b0 x itself past 32 at 64 samples, so sum in 64 and clip the step like the ADC
+    int64_t y = ((int64_t)filter->b0 * x + (int64_t)filter->b1 * last + (1 << (MIMIC_SHIFT - 1))) >> MIMIC_SHIFT;
+    return (sample_t)(y > INT16_MAX ? INT16_MAX : y < INT16_MIN ? INT16_MIN : y);
+#else
+    return filter->b0 * x + filter->b1 * last;
+#endif
+}
+
+#if RELAY_DC_FILTER == RELAY_DC_MIMIC
+
+// Design the filter of the relay on the nominal period, before the acquisition starts
+void mimic_init(uint32_t period_us);
+
+// Filter a scan of every channel in place, the sliding DFT
+void mimicScan(sample_t *scan);
+
+// Filter a cycle of every channel in place, the cycle DFT
+void mimicCycle(sample_t (*samples)[sample_times]);
+
+// mimicRelative of the relay's filter, 1 without one
+void mimicCompensation(int harmonic, double *real, double *img);
+
+#else
+
+static inline void mimic_init(uint32_t period_us){ (void)period_us; }
+
+static inline void mimicScan(sample_t *scan){ (void)scan; }
+
+static inline void mimicCycle(sample_t (*samples)[sample_times]){ (void)samples; }
+
+static inline void mimicCompensation(int harmonic, double *real, double *img){ (void)harmonic; *real = 1.0; *img = 0.0; }
+
+#endif
@@ -0,0 +1,84 @@
+#pragma once
+
+// PSM of every progress table point, the squares are semi-log spaced:
+// PSM2_STEPS even steps inside each octave of PSM squared, from 1 to 2^PSM2_OCTAVES
+// X is applied to each PSM with the remaining arguments, the results are comma separated
+
+#define PSM2_STEP_BITS 4
+#define PSM2_STEPS (1 << PSM2_STEP_BITS)
+#define PSM2_OCTAVES 12
+
+#define PSM_BREAKPOINTS(X, ...) \
+    X(1.0, __VA_ARGS__), X(1.0307764064044151, __VA_ARGS__), X(1.0606601717798213, __VA_ARGS__), \
+    X(1.0897247358851684, __VA_ARGS__), X(1.1180339887498948, __VA_ARGS__), X(1.14564392373896, __VA_ARGS__), \
+    X(1.1726039399558574, __VA_ARGS__), X(1.1989578808281799, __VA_ARGS__), X(1.224744871391589, __VA_ARGS__), \
+    X(1.25, __VA_ARGS__), X(1.2747548783981962, __VA_ARGS__), X(1.299038105676658, __VA_ARGS__), \
+    X(1.3228756555322953, __VA_ARGS__), X(1.346291201783626, __VA_ARGS__), X(1.3693063937629153, __VA_ARGS__), \
+    X(1.3919410907075055, __VA_ARGS__), X(1.414213562373095, __VA_ARGS__), X(1.4577379737113251, __VA_ARGS__), \
+    X(1.5, __VA_ARGS__), X(1.5411035007422441, __VA_ARGS__), X(1.5811388300841897, __VA_ARGS__), \
+    X(1.6201851746019651, __VA_ARGS__), X(1.6583123951776999, __VA_ARGS__), X(1.695582495781317, __VA_ARGS__), \
+    X(1.7320508075688773, __VA_ARGS__), X(1.7677669529663688, __VA_ARGS__), X(1.8027756377319946, __VA_ARGS__), \
+    X(1.8371173070873836, __VA_ARGS__), X(1.8708286933869707, __VA_ARGS__), X(1.9039432764659771, __VA_ARGS__), \
+    X(1.9364916731037084, __VA_ARGS__), X(1.9685019685029528, __VA_ARGS__), X(2.0, __VA_ARGS__), \
+    X(2.0615528128088303, __VA_ARGS__), X(2.1213203435596426, __VA_ARGS__), X(2.1794494717703368, __VA_ARGS__), \
+    X(2.2360679774997897, __VA_ARGS__), X(2.29128784747792, __VA_ARGS__), X(2.3452078799117148, __VA_ARGS__), \
+    X(2.3979157616563598, __VA_ARGS__), X(2.4494897427831781, __VA_ARGS__), X(2.5, __VA_ARGS__), \
+    X(2.5495097567963924, __VA_ARGS__), X(2.5980762113533159, __VA_ARGS__), X(2.6457513110645906, __VA_ARGS__), \
+    X(2.692582403567252, __VA_ARGS__), X(2.7386127875258306, __VA_ARGS__), X(2.783882181415011, __VA_ARGS__), \
+    X(2.8284271247461901, __VA_ARGS__), X(2.9154759474226502, __VA_ARGS__), X(3.0, __VA_ARGS__), \
+    X(3.0822070014844882, __VA_ARGS__), X(3.1622776601683793, __VA_ARGS__), X(3.2403703492039301, __VA_ARGS__), \
+    X(3.3166247903553998, __VA_ARGS__), X(3.3911649915626341, __VA_ARGS__), X(3.4641016151377546, __VA_ARGS__), \
+    X(3.5355339059327376, __VA_ARGS__), X(3.6055512754639893, __VA_ARGS__), X(3.6742346141747671, __VA_ARGS__), \
+    X(3.7416573867739414, __VA_ARGS__), X(3.8078865529319541, __VA_ARGS__), X(3.8729833462074169, __VA_ARGS__), \
+    X(3.9370039370059055, __VA_ARGS__), X(4.0, __VA_ARGS__), X(4.1231056256176605, __VA_ARGS__), \
+    X(4.2426406871192851, __VA_ARGS__), X(4.3588989435406736, __VA_ARGS__), X(4.4721359549995794, __VA_ARGS__), \
+    X(4.58257569495584, __VA_ARGS__), X(4.6904157598234296, __VA_ARGS__), X(4.7958315233127195, __VA_ARGS__), \
+    X(4.8989794855663562, __VA_ARGS__), X(5.0, __VA_ARGS__), X(5.0990195135927848, __VA_ARGS__), \
+    X(5.1961524227066319, __VA_ARGS__), X(5.2915026221291812, __VA_ARGS__), X(5.385164807134504, __VA_ARGS__), \
+    X(5.4772255750516611, __VA_ARGS__), X(5.5677643628300219, __VA_ARGS__), X(5.6568542494923802, __VA_ARGS__), \
+    X(5.8309518948453005, __VA_ARGS__), X(6.0, __VA_ARGS__), X(6.1644140029689765, __VA_ARGS__), \
+    X(6.3245553203367587, __VA_ARGS__), X(6.4807406984078602, __VA_ARGS__), X(6.6332495807107997, __VA_ARGS__), \
+    X(6.7823299831252681, __VA_ARGS__), X(6.9282032302755092, __VA_ARGS__), X(7.0710678118654752, __VA_ARGS__), \
+    X(7.2111025509279786, __VA_ARGS__), X(7.3484692283495343, __VA_ARGS__), X(7.4833147735478828, __VA_ARGS__), \
+    X(7.6157731058639083, __VA_ARGS__), X(7.7459666924148338, __VA_ARGS__), X(7.874007874011811, __VA_ARGS__), \
+    X(8.0, __VA_ARGS__), X(8.2462112512353211, __VA_ARGS__), X(8.4852813742385703, __VA_ARGS__), \
+    X(8.7177978870813471, __VA_ARGS__), X(8.9442719099991588, __VA_ARGS__), X(9.16515138991168, __VA_ARGS__), \
+    X(9.3808315196468591, __VA_ARGS__), X(9.5916630466254391, __VA_ARGS__), X(9.7979589711327124, __VA_ARGS__), \
+    X(10.0, __VA_ARGS__), X(10.1980390271855697, __VA_ARGS__), X(10.3923048454132638, __VA_ARGS__), \
+    X(10.5830052442583624, __VA_ARGS__), X(10.7703296142690081, __VA_ARGS__), X(10.9544511501033223, __VA_ARGS__), \
+    X(11.1355287256600438, __VA_ARGS__), X(11.3137084989847604, __VA_ARGS__), X(11.6619037896906009, __VA_ARGS__), \
+    X(12.0, __VA_ARGS__), X(12.3288280059379529, __VA_ARGS__), X(12.6491106406735173, __VA_ARGS__), \
+    X(12.9614813968157205, __VA_ARGS__), X(13.2664991614215994, __VA_ARGS__), X(13.5646599662505363, __VA_ARGS__), \
+    X(13.8564064605510183, __VA_ARGS__), X(14.1421356237309505, __VA_ARGS__), X(14.4222051018559572, __VA_ARGS__), \
+    X(14.6969384566990686, __VA_ARGS__), X(14.9666295470957655, __VA_ARGS__), X(15.2315462117278166, __VA_ARGS__), \
+    X(15.4919333848296675, __VA_ARGS__), X(15.748015748023622, __VA_ARGS__), X(16.0, __VA_ARGS__), \
+    X(16.4924225024706422, __VA_ARGS__), X(16.9705627484771406, __VA_ARGS__), X(17.4355957741626942, __VA_ARGS__), \
+    X(17.8885438199983176, __VA_ARGS__), X(18.33030277982336, __VA_ARGS__), X(18.7616630392937182, __VA_ARGS__), \
+    X(19.1833260932508782, __VA_ARGS__), X(19.5959179422654248, __VA_ARGS__), X(20.0, __VA_ARGS__), \
+    X(20.3960780543711393, __VA_ARGS__), X(20.7846096908265275, __VA_ARGS__), X(21.1660104885167247, __VA_ARGS__), \
+    X(21.5406592285380161, __VA_ARGS__), X(21.9089023002066445, __VA_ARGS__), X(22.2710574513200877, __VA_ARGS__), \
+    X(22.6274169979695208, __VA_ARGS__), X(23.3238075793812019, __VA_ARGS__), X(24.0, __VA_ARGS__), \
+    X(24.6576560118759058, __VA_ARGS__), X(25.2982212813470347, __VA_ARGS__), X(25.9229627936314409, __VA_ARGS__), \
+    X(26.5329983228431988, __VA_ARGS__), X(27.1293199325010726, __VA_ARGS__), X(27.7128129211020367, __VA_ARGS__), \
+    X(28.284271247461901, __VA_ARGS__), X(28.8444102037119143, __VA_ARGS__), X(29.3938769133981372, __VA_ARGS__), \
+    X(29.9332590941915311, __VA_ARGS__), X(30.4630924234556331, __VA_ARGS__), X(30.9838667696593351, __VA_ARGS__), \
+    X(31.4960314960472441, __VA_ARGS__), X(32.0, __VA_ARGS__), X(32.9848450049412844, __VA_ARGS__), \
+    X(33.9411254969542812, __VA_ARGS__), X(34.8711915483253884, __VA_ARGS__), X(35.7770876399966351, __VA_ARGS__), \
+    X(36.6606055596467201, __VA_ARGS__), X(37.5233260785874364, __VA_ARGS__), X(38.3666521865017563, __VA_ARGS__), \
+    X(39.1918358845308496, __VA_ARGS__), X(40.0, __VA_ARGS__), X(40.7921561087422786, __VA_ARGS__), \
+    X(41.569219381653055, __VA_ARGS__), X(42.3320209770334494, __VA_ARGS__), X(43.0813184570760323, __VA_ARGS__), \
+    X(43.8178046004132891, __VA_ARGS__), X(44.5421149026401754, __VA_ARGS__), X(45.2548339959390416, __VA_ARGS__), \
+    X(46.6476151587624038, __VA_ARGS__), X(48.0, __VA_ARGS__), X(49.3153120237518116, __VA_ARGS__), \
+    X(50.5964425626940693, __VA_ARGS__), X(51.8459255872628818, __VA_ARGS__), X(53.0659966456863976, __VA_ARGS__), \
+    X(54.2586398650021451, __VA_ARGS__), X(55.4256258422040734, __VA_ARGS__), X(56.568542494923802, __VA_ARGS__), \
+    X(57.6888204074238287, __VA_ARGS__), X(58.7877538267962744, __VA_ARGS__), X(59.8665181883830622, __VA_ARGS__), \
+    X(60.9261848469112663, __VA_ARGS__), X(61.9677335393186702, __VA_ARGS__), X(62.9920629920944882, __VA_ARGS__), \
+    X(64.0, __VA_ARGS__)
+
+// PSM squared of every reset table point, PSM2_STEPS even steps from 0 to 1
+#define RESET_BREAKPOINTS(X, ...) \
+    X(0.0, __VA_ARGS__), X(0.0625, __VA_ARGS__), X(0.125, __VA_ARGS__), X(0.1875, __VA_ARGS__), \
+    X(0.25, __VA_ARGS__), X(0.3125, __VA_ARGS__), X(0.375, __VA_ARGS__), X(0.4375, __VA_ARGS__), \
+    X(0.5, __VA_ARGS__), X(0.5625, __VA_ARGS__), X(0.625, __VA_ARGS__), X(0.6875, __VA_ARGS__), \
+    X(0.75, __VA_ARGS__), X(0.8125, __VA_ARGS__), X(0.875, __VA_ARGS__), X(0.9375, __VA_ARGS__), \
+    X(1.0, __VA_ARGS__)
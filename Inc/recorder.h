@@ -0,0 +1,85 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "relay_config.h"
+
+// Disturbance recorder, the raw ADC codes around a pickup or a trip kept in RAM
+// Every power cycle is one compressed block in a byte ring, written from the acquisition
+// interrupt. A trigger keeps the pre-trigger cycles, the post-trigger cycles are added and
+// the record freezes until recorderRearm(). Read disturbance with the debugger and turn it
+// into COMTRADE with the host tool in Sim/Tools
+
+// Block layout, little endian, every block is one cycle of every channel
+//   uint16 length     bytes of the whole block
+//   uint16 period     g_current_period of the cycle in 1MHz ticks
+//   width nibbles     bits per delta of each channel, two channels per byte
+//   bit stream        per channel the first code in adc_bits then the zigzag deltas, LSB first
+#define RECORDER_MAGIC 0x44524352u  // "RCRD"
+#define RECORDER_BLOCK_HEADER 4
+
+// Delta width that stores the code itself, a full scale step needs one bit more than a code
+#define RECORDER_MAX_WIDTH 15
+
+typedef enum {
+    RECORDER_ARMED,     // Keeping the latest cycles, waiting for a trigger
+    RECORDER_TRIGGERED, // Adding the post-trigger cycles
+    RECORDER_DONE,      // Frozen, nothing is written until rearmed
+} recorderState;
+
+typedef enum {
+    RECORDER_CAUSE_NONE,
+    RECORDER_CAUSE_PICKUP,
+    RECORDER_CAUSE_TRIP,
+} recorderCause;
+
+// Everything the host tool needs to decode the ring, fixed width fields only
+typedef struct {
+    uint32_t magic;
+    uint32_t state;
+    uint16_t channels;      // In rank order, see the CH_ defines
+    uint16_t samples;       // Scans per cycle
+    uint16_t adc_bits;
+    uint16_t cause;
+    uint16_t cycles;        // Blocks in the record
+    uint16_t pre_cycles;    // Blocks before the trigger
+    uint32_t start;         // Ring offset of the first block
+    uint32_t length;        // Bytes of the record from start, wrapping at capacity
+    uint32_t capacity;      // Ring bytes, a power of two
+} recorderHeader;
+
+#if RELAY_RECORDER
+
+#if RECORDER_BYTES & (RECORDER_BYTES - 1)
+#error "RECORDER_BYTES must be a power of two"
+#endif
+
+typedef struct {
+    recorderHeader header;
+    uint8_t ring[RECORDER_BYTES];
+} recorderImage;
+
+extern recorderImage disturbance;
+
+void recorder_init(void);
+
+// One cycle of raw scans, channel codes interleaved in rank order, from the acquisition interrupt
+void recorderCycle(const uint16_t *raw, uint32_t period);
+
+// Start the post-trigger window, ignored unless armed
+void recorderTrigger(recorderCause cause);
+
+// Drop the frozen record and start keeping cycles again
+void recorderRearm(void);
+
+#else
+
+static inline void recorder_init(void){}
+
+static inline void recorderCycle(const uint16_t *raw, uint32_t period){ (void)raw; (void)period; }
+
+static inline void recorderTrigger(recorderCause cause){ (void)cause; }
+
+static inline void recorderRearm(void){}
+
+#endif
@@ -0,0 +1,279 @@
+#pragma once
+
+// Build time configuration of the relay
+// Every knob here can be overridden from CMake, the defaults are what runs on the board
+
+// Numeric modes for the protection hot path
+#define RELAY_NUMERIC_DOUBLE 0  // Reference implementation, soft float on the M4
+#define RELAY_NUMERIC_FLOAT  1  // Single precision, runs on the fpv4-sp-d16 FPU
+#define RELAY_NUMERIC_FIXED  2  // Q15 samples and twiddles, wide integer accumulators
+
+#ifndef RELAY_NUMERIC
+#define RELAY_NUMERIC RELAY_NUMERIC_FLOAT
+#endif
+
+// Decaying DC offset of a fault current in the phasors
+#define RELAY_DC_NONE  0  // The plain cycle correlation, the offset leaks into it for a few cycles
+#define RELAY_DC_MIMIC 1  // Digital mimic filter ahead of the DFT, see Inc/mimic.h
+
+#ifndef RELAY_DC_FILTER
+#define RELAY_DC_FILTER RELAY_DC_MIMIC
+#endif
+
+// Time constant of the offset the mimic cancels, the X/R of the feeder over omega
+#ifndef DC_TAU_MS
+#define DC_TAU_MS 40
+#endif
+
+// Acquisition modes
+#define RELAY_ACQ_IT  0  // One ADC interrupt per conversion
+#define RELAY_ACQ_DMA 1  // Circular DMA, one event per power cycle
+
+#ifndef RELAY_ACQ
+#define RELAY_ACQ RELAY_ACQ_DMA
+#endif
+
+// Phasor estimation
+#define RELAY_DFT_CYCLE   0  // Full correlation once per cycle
+#define RELAY_DFT_SLIDING 1  // Recursive update and a decision on every sample
+
+#ifndef RELAY_DFT
+#define RELAY_DFT RELAY_DFT_SLIDING
+#endif
+
+#if RELAY_DFT == RELAY_DFT_SLIDING && RELAY_ACQ != RELAY_ACQ_DMA
+#error "The sliding DFT reads the scans straight out of the DMA buffer, set RELAY_ACQ to DMA"
+#endif
+
+// ADC conversions decimated into each sample, 1 converts once per sample at 10 bit,
+// 4 or 16 convert at 12 bit and decimate to 13 or 14, see Inc/decimator.h
+#ifndef RELAY_OVERSAMPLE
+#define RELAY_OVERSAMPLE 1
+#endif
+
+#if RELAY_OVERSAMPLE != 1 && RELAY_OVERSAMPLE != 4 && RELAY_OVERSAMPLE != 16
+#error "RELAY_OVERSAMPLE must be 1, 4 or 16"
+#endif
+
+#if RELAY_OVERSAMPLE > 1 && RELAY_ACQ != RELAY_ACQ_DMA
+#error "Oversampling collects its bursts with the DMA, set RELAY_ACQ to DMA"
+#endif
+
+// Samples taken per power cycle, one of 12, 16, 24, 32 or 64
+#ifndef RELAY_SAMPLES
+#define RELAY_SAMPLES 12
+#endif
+
+#define sample_times RELAY_SAMPLES
+
+// Protection decisions per power cycle, each progress step covers that fraction of a cycle
+#if RELAY_DFT == RELAY_DFT_SLIDING
+#define decision_times sample_times
+#else
+#define decision_times 1
+#endif
+
+// Range the frequency tracker follows, crossings and phasors outside it are taken as noise
+#ifndef FREQUENCY_MIN_HZ
+#define FREQUENCY_MIN_HZ 40
+#endif
+
+#ifndef FREQUENCY_MAX_HZ
+#define FREQUENCY_MAX_HZ 70
+#endif
+
+// Progress of an element that drops below pickup
+#define RELAY_RESET_INSTANT 0  // Back to 0 at once
+#define RELAY_RESET_DISC    1  // Winds back along the reset curve like an induction disc
+
+#ifndef RELAY_RESET
+#define RELAY_RESET RELAY_RESET_DISC
+#endif
+
+// Latency probes on the DWT cycle counter, 0 compiles them out
+#ifndef RELAY_PROFILE
+#define RELAY_PROFILE 0
+#endif
+
+// Where the DFT and the decisions run, 0 in the main loop with the rest of the tasks,
+// 1 in an interrupt of their own right behind the acquisition, see Inc/scheduler.h
+#ifndef RELAY_TRIP_ISR
+#define RELAY_TRIP_ISR 0
+#endif
+
+// Disturbance recorder in RAM, 0 compiles it out
+#ifndef RELAY_RECORDER
+#define RELAY_RECORDER 1
+#endif
+
+// What starts the post-trigger window of the recorder
+#define RELAY_RECORDER_PICKUP 0  // Any element picking up
+#define RELAY_RECORDER_TRIP   1  // The relay tripping
+
+#ifndef RELAY_RECORDER_TRIGGER
+#define RELAY_RECORDER_TRIGGER RELAY_RECORDER_PICKUP
+#endif
+
+// Cycles kept before and after the trigger
+#ifndef RECORDER_PRE_CYCLES
+#define RECORDER_PRE_CYCLES 10
+#endif
+
+#ifndef RECORDER_POST_CYCLES
+#define RECORDER_POST_CYCLES 50
+#endif
+
+// The post-trigger window counts down to the freeze in 16 bits and the record header
+// holds both windows together in 16 bits
+#if RECORDER_POST_CYCLES < 1 || RECORDER_PRE_CYCLES < 0 || RECORDER_PRE_CYCLES + RECORDER_POST_CYCLES > 65535
+#error "RECORDER_POST_CYCLES must be at least 1 and RECORDER_PRE_CYCLES + RECORDER_POST_CYCLES at most 65535"
+#endif
+
+// The ring takes most of the RAM the F401 has left, compression makes it hold far more than the window
+#ifndef RECORDER_BYTES
+#define RECORDER_BYTES 65536
+#endif
+
+// Binary telemetry frames out of USART2 by DMA, 0 compiles it out
+#ifndef RELAY_TELEMETRY
+#define RELAY_TELEMETRY 1
+#endif
+
+// One frame a cycle has to fit in a cycle, 112 bytes with three phases take 9.7 ms at 115200
+#ifndef TELEMETRY_BAUD
+#define TELEMETRY_BAUD 115200
+#endif
+
+// Instantaneous overcurrent on the raw samples, 0 compiles it out
+#ifndef RELAY_INSTANT
+#define RELAY_INSTANT 1
+#endif
+
+// How the instantaneous element sizes the current from the samples
+#define RELAY_INSTANT_PAIR 0  // Two samples a quarter cycle apart, a quarter cycle to see a step
+#define RELAY_INSTANT_HALF 1  // Rectified mean of the last half cycle, rides over a spike
+#define RELAY_INSTANT_PEAK 2  // The latest sample alone, fastest and the most exposed to offset
+
+#ifndef RELAY_INSTANT_ESTIMATOR
+#define RELAY_INSTANT_ESTIMATOR RELAY_INSTANT_PAIR
+#endif
+
+// Harmonic phasors of every channel and the second harmonic inrush restraint, 0 compiles them out
+#ifndef RELAY_HARMONIC
+#define RELAY_HARMONIC 1
+#endif
+
+// Highest harmonic in the bank, the ones from the second up to it are computed
+#ifndef HARMONIC_MAX
+#define HARMONIC_MAX 5
+#endif
+
+#if RELAY_HARMONIC && (HARMONIC_MAX < 2 || 2 * HARMONIC_MAX >= sample_times)
+#error "HARMONIC_MAX must be 2 or more and below half of RELAY_SAMPLES"
+#endif
+
+// Voltage memory polarizing the phase elements through a close-in fault, 0 compiles it out
+#ifndef RELAY_MEMORY
+#define RELAY_MEMORY 1
+#endif
+
+// Peak volts at the pin below which a phase voltage counts as collapsed
+#ifndef MEMORY_MIN_VOLTS
+#define MEMORY_MIN_VOLTS 0.1
+#endif
+
+// Power cycles the memory stays usable once the voltage stops refreshing it
+#ifndef MEMORY_CYCLES
+#define MEMORY_CYCLES 10
+#endif
+
+#if MEMORY_CYCLES < 1 || MEMORY_CYCLES > 255
+#error "MEMORY_CYCLES must be 1 to 255"
+#endif
+
+// Setting groups, all compiled at boot so a switch is a pointer swap between two power cycles
+#ifndef SETTING_GROUPS
+#define SETTING_GROUPS 3
+#endif
+
+#if SETTING_GROUPS < 1 || SETTING_GROUPS > 8
+#error "SETTING_GROUPS must be 1 to 8"
+#endif
+
+// Binary coded group select inputs from PB4 up, closed to ground is a 1, 0 leaves the group to commands
+#ifndef GROUP_INPUTS
+#define GROUP_INPUTS 2
+#endif
+
+#if GROUP_INPUTS < 0 || GROUP_INPUTS > 3
+#error "GROUP_INPUTS must be 0 to 3"
+#endif
+
+// Power cycles a new code has to stay on the inputs before the group follows it
+#ifndef GROUP_DEBOUNCE
+#define GROUP_DEBOUNCE 3
+#endif
+
+// Single phase or three phase with a residual element
+#ifndef RELAY_PHASES
+#define RELAY_PHASES 1
+#endif
+
+#if RELAY_PHASES != 1 && RELAY_PHASES != 3
+#error "RELAY_PHASES must be 1 or 3"
+#endif
+
+// Residual (ground) current source in three phase mode
+#define RELAY_RESIDUAL_NONE       0  // Phase elements only
+#define RELAY_RESIDUAL_CALCULATED 1  // Ia + Ib + Ic, six ADC channels
+#define RELAY_RESIDUAL_MEASURED   2  // A seventh channel from a core balance CT
+
+#ifndef RELAY_RESIDUAL
+#define RELAY_RESIDUAL RELAY_RESIDUAL_MEASURED
+#endif
+
+// Channels in one ADC scan, in rank order
+#define CH_IA 0
+#define CH_VA 1
+
+#if RELAY_PHASES == 3
+#define CH_IB 2
+#define CH_VB 3
+#define CH_IC 4
+#define CH_VC 5
+#if RELAY_RESIDUAL == RELAY_RESIDUAL_MEASURED
+#define CH_IN 6
+#define ADC_CHANNELS 7
+#else
+#define ADC_CHANNELS 6
+#endif
+#else
+#define ADC_CHANNELS 2
+#endif
+
+// Independent protection elements, one per phase and the residual
+#if RELAY_PHASES == 3 && RELAY_RESIDUAL != RELAY_RESIDUAL_NONE
+#define RELAY_ELEMENTS 4
+#define ELEMENT_RESIDUAL 3
+#else
+#define RELAY_ELEMENTS RELAY_PHASES
+#endif
+
+// Per channel gain and phase on the phasors, see Inc/calibration.h
+#ifndef RELAY_CALIBRATION
+#define RELAY_CALIBRATION 1
+#endif
+
+// ADC scaling, the samples are mapped from counts to volts with these
+// Oversampled these are the decimated codes, half a bit more per doubling of the rate
+#if RELAY_OVERSAMPLE == 16
+#define ADC_BITS 14
+#define ADC_FULL_SCALE 16383.0
+#elif RELAY_OVERSAMPLE == 4
+#define ADC_BITS 13
+#define ADC_FULL_SCALE 8191.0
+#else
+#define ADC_BITS 10
+#define ADC_FULL_SCALE 1023.0
+#endif
+#define ADC_VREF 3.3
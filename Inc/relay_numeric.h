@@ -0,0 +1,196 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include "relay_config.h"
+
+// Numeric types of the protection pipeline, selected by RELAY_NUMERIC
+// Settings and boot time tables stay in double, only the per cycle path uses these
+
+#if RELAY_NUMERIC == RELAY_NUMERIC_FIXED
+
+typedef int16_t sample_t;     // Raw ADC counts
+typedef int16_t twiddle_t;    // Q15
+typedef int32_t phasor_t;     // ADC counts in Q15
+typedef int64_t power_t;      // phasor_t squared
+typedef int64_t acc_t;        // DFT sums of counts times Q15
+
+// Round a literal into Q15 at compile time, +1.0 does not fit so saturate it
+#define TWIDDLE(x) ((twiddle_t)((x) >= 1.0 ? 32767 : (x) < 0 ? (int32_t)((x) * 32768.0 - 0.5) : (int32_t)((x) * 32768.0 + 0.5)))
+typedef uint32_t rate_t;      // Progress per timer tick in Q30
+typedef uint32_t dial_t;      // Time dial multiplier in Q16.16
+typedef uint32_t psm2_t;      // PSM squared in Q16.16
+typedef uint32_t progress_t;  // Q16.16 of the 65535 trip scale
+
+#define Q15_ONE 32768.0
+#define PHASOR_PER_VOLT ((ADC_FULL_SCALE / ADC_VREF) * Q15_ONE)
+// The fastest point of any curve, IEC extremely inverse at 64 times pickup, is near
+// 3.4 million per second and fits 32 bits with a decision a cycle at this shift
+#define RATE_SHIFT 14
+#define PROGRESS_TRIP ((progress_t)65535 << 16)
+
+#else
+
+#if RELAY_NUMERIC == RELAY_NUMERIC_DOUBLE
+typedef double real_t;
+#define real_sqrt sqrt
+#else
+typedef float real_t;
+#define real_sqrt sqrtf
+#endif
+
+typedef real_t sample_t;      // Volts
+typedef real_t twiddle_t;
+typedef real_t phasor_t;      // Volts
+typedef real_t power_t;       // Volts squared
+typedef real_t acc_t;
+
+#define TWIDDLE(x) ((twiddle_t)(x))
+typedef real_t rate_t;        // Progress per second
+typedef real_t dial_t;
+typedef real_t psm2_t;
+
+#if RELAY_NUMERIC == RELAY_NUMERIC_DOUBLE
+typedef double progress_t;
+#define PROGRESS_TRIP ((progress_t)65535)
+#else
+// Small steps vanish when added to a float near 65535, so accumulate in Q16.16
+typedef uint32_t progress_t;
+#define PROGRESS_TRIP ((progress_t)65535 << 16)
+#endif
+
+#define PHASOR_PER_VOLT 1.0
+
+#endif
+
+// Convert an ADC reading into a sample, replaces the old map() call in the ISR
+static inline sample_t toSample(uint32_t adc_val){
+#if RELAY_NUMERIC == RELAY_NUMERIC_FIXED
+    return (sample_t)adc_val;
+#else
+    return (real_t)adc_val * (real_t)(ADC_VREF / ADC_FULL_SCALE);
+#endif
+}
+
+// Convert a cos or sin value into a twiddle factor
+static inline twiddle_t toTwiddle(double value){
+#if RELAY_NUMERIC == RELAY_NUMERIC_FIXED
+    double q = round(value * Q15_ONE);
+    // +1.0 does not fit in Q15 so saturate it
+    return (twiddle_t)(q > 32767.0 ? 32767.0 : q);
+#else
+    return (twiddle_t)value;
+#endif
+}
+
+// The RMS squared of a current in volts, in the units of getRMSquared
+static inline power_t toPower(double volts){
+    double scaled = volts * PHASOR_PER_VOLT;
+    return (power_t)(scaled * scaled);
+}
+
+// Convert a progress rate per second for the flash tables, with the decision rate folded in for fixed point
+// progress += rate * period / (samples * 1MHz) is then a single multiply and shift
+#if RELAY_NUMERIC == RELAY_NUMERIC_FIXED
+#define RATE_Q(per_second) ((per_second) / (decision_times * 1000000.0) * 65536.0 * (double)(1u << RATE_SHIFT))
+#define RATE(per_second) (RATE_Q(per_second) > 4294967295.0 ? (rate_t)UINT32_MAX : (rate_t)RATE_Q(per_second))
+#else
+#define RATE(per_second) ((rate_t)(per_second))
+#endif
+
+// Convert the time dial multiplier, done once per setting change
+// In floating point the decision step is folded in too, a scaled rate is then progress per 1MHz tick
+static inline dial_t toDial(double scale){
+#if RELAY_NUMERIC == RELAY_NUMERIC_FIXED
+    double q = scale * 65536.0;
+    return (dial_t)(q > 4294967295.0 ? 4294967295.0 : q);
+#else
+    return (dial_t)(scale / (decision_times * 1000000.0));
+#endif
+}
+
+// Apply the time dial to a table rate, the one multiply left of the curve evaluation
+static inline rate_t scaleRate(rate_t rate, dial_t dial){
+#if RELAY_NUMERIC == RELAY_NUMERIC_FIXED
+    uint64_t scaled = ((uint64_t)rate * dial) >> 16;
+    return scaled > UINT32_MAX ? UINT32_MAX : (rate_t)scaled;
+#else
+    return rate * dial;
+#endif
+}
+
+// Progress covered by one decision of a cycle of period_ticks, at a rate scaled by the dial
+static inline progress_t progressDelta(rate_t rate, uint32_t period_ticks){
+#if RELAY_NUMERIC == RELAY_NUMERIC_FIXED
+    // More than the whole travel in one decision on the fastest points, saturate
+    uint64_t step = ((uint64_t)rate * period_ticks) >> RATE_SHIFT;
+    return step > UINT32_MAX ? UINT32_MAX : (progress_t)step;
+#elif RELAY_NUMERIC == RELAY_NUMERIC_DOUBLE
+    return rate * (real_t)period_ticks;
+#else
+    real_t step = rate * (real_t)period_ticks * (real_t)65536.0;
+    return step < (real_t)4294967295.0 ? (uint32_t)step : UINT32_MAX;
+#endif
+}
+
+// Advance the progress by one decision
+static inline progress_t stepProgress(progress_t progress, rate_t rate, uint32_t period_ticks){
+#if RELAY_NUMERIC == RELAY_NUMERIC_DOUBLE
+    return progress + progressDelta(rate, period_ticks);
+#else
+    uint64_t next = (uint64_t)progress + progressDelta(rate, period_ticks);
+    // Saturate instead of wrapping back to an untripped value
+    return next > UINT32_MAX ? UINT32_MAX : (progress_t)next;
+#endif
+}
+
+// Wind the progress back by one decision, it stops at 0
+static inline progress_t unwindProgress(progress_t progress, rate_t rate, uint32_t period_ticks){
+    progress_t step = progressDelta(rate, period_ticks);
+    return step < progress ? progress - step : 0;
+}
+
+// Pickup in the units of getRMSquared, with its reciprocal so the PSM squared is a multiply
+typedef struct {
+    power_t squared;
+#if RELAY_NUMERIC == RELAY_NUMERIC_FIXED
+    uint32_t inverse;   // 2^31 / (squared >> shift)
+    uint8_t shift;      // Brings squared down to 16 bits
+#else
+    real_t inverse;     // 1 / squared
+#endif
+} pickupScale;
+
+static inline pickupScale toPickup(double volts){
+    pickupScale pickup;
+    pickup.squared = toPower(volts);
+#if RELAY_NUMERIC == RELAY_NUMERIC_FIXED
+    uint8_t shift = 0;
+    while((pickup.squared >> shift) >= (1 << 16)){
+        shift++;
+    }
+    uint64_t reduced = (uint64_t)(pickup.squared >> shift);
+    pickup.shift = shift;
+    pickup.inverse = (uint32_t)((1ull << 31) / (reduced ? reduced : 1));
+#else
+    pickup.inverse = (real_t)(1.0 / (double)pickup.squared);
+#endif
+    return pickup;
+}
+
+// PSM squared of a measured RMS squared, no square root and no divide
+static inline psm2_t psm2Ratio(power_t fund_sqcurrent, const pickupScale *pickup){
+#if RELAY_NUMERIC == RELAY_NUMERIC_FIXED
+    uint64_t reduced = (uint64_t)(fund_sqcurrent >> pickup->shift);
+    // Far beyond the last table point either way, just saturate
+    if(reduced > UINT32_MAX){
+        return UINT32_MAX;
+    }
+    uint64_t ratio = (reduced * pickup->inverse) >> 15;
+    return ratio > UINT32_MAX ? UINT32_MAX : (psm2_t)ratio;
+#else
+    return fund_sqcurrent * pickup->inverse;
+#endif
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "stm32f4xx_hal.h"
+#include "relay_config.h"
+
+// Event driven main loop, the core sleeps in WFI until an interrupt posts work
+// The interrupts only post tasks, the tasks run in thread mode in the order of
+// schedulerTask, the lowest first, and the core goes back to sleep once none is pending.
+// Every power cycle the time awake is added up into cpu_load, read it with the debugger
+// or from the telemetry
+// With RELAY_TRIP_ISR a post of TASK_ACQUISITION pends PROTECTION_IRQn instead, and the
+// task runs in that interrupt the moment the acquisition interrupt returns. Nothing in
+// the loop or the telemetry can hold a decision back then, the loop keeps the rest
+
+// Deferred work in the order it runs
+typedef enum {
+    TASK_ACQUISITION,   // A scan or a cycle is waiting, the DFT and the protection
+    TASK_CYCLE,         // Once a power cycle after the protection, frequency and load
+    TASK_COUNT
+} schedulerTask;
+
+typedef void (*taskHandler)(void);
+
+typedef struct {
+    uint32_t busy;          // Core cycles awake in the last power cycle, the interrupts included
+    uint32_t idle;          // Core cycles asleep in the last power cycle
+    uint16_t load;          // busy of the last power cycle in permille of the cycle
+    uint16_t peak;          // Highest load since reset
+    uint32_t wakeups;       // Times the core left WFI in the last power cycle
+    uint32_t overloads;     // Power cycles with no idle time left
+} cpuLoad;
+
+extern cpuLoad cpu_load;
+
+// Start the cycle counter the load is measured on
+void scheduler_init(void);
+
+// Make a task pending, from an interrupt or from another task
+void schedulerPost(schedulerTask task);
+
+// Close the load of the power cycle that just ended, once a cycle from a task
+void schedulerCycle(void);
+
+// Run the tasks forever, tasks is indexed by schedulerTask
+void schedulerRun(const taskHandler tasks[TASK_COUNT]) __attribute__((noreturn));
+
+#if RELAY_TRIP_ISR
+
+// No EXTI line is routed to it, only the NVIC pends it from software. Below the
+// acquisition so a scan is never late for a decision, above the telemetry and the loop
+#define PROTECTION_IRQn EXTI0_IRQn
+#define PROTECTION_PRIORITY 2
+
+// Body of the protection interrupt, runs TASK_ACQUISITION
+void schedulerProtection(void);
+
+// Keep the protection out while the loop touches what the decisions read
+static inline void protectionLock(void){
+    HAL_NVIC_DisableIRQ(PROTECTION_IRQn);
+}
+
+static inline void protectionUnlock(void){
+    HAL_NVIC_EnableIRQ(PROTECTION_IRQn);
+}
+
+#else
+
+static inline void protectionLock(void){}
+
+static inline void protectionUnlock(void){}
+
+#endif
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "relay_config.h"
+#include "relay_numeric.h"
+#include "curves.h"
+#include "instantaneous.h"
+#include "harmonic.h"
+
+// Settings in the units of the hot path, compiled once from a relayType so a decision
+// does no transcendental math and no division. Every setting group has its own compiled
+// bank pointing at its curve row in flash, switching groups is a single pointer store.
+// Changes are compiled into a spare bank that swaps with the group's own, the decisions
+// only ever see whole banks and the swaps happen once a power cycle between two decisions
+
+// The groups the defaults in main.c fill in, groups past these start as copies of the normal one
+#define GROUP_NORMAL      0
+#define GROUP_COLD_LOAD   1     // Higher pickup for the inrush after a long outage
+#define GROUP_MAINTENANCE 2     // Sensitive and fast while people work on the feeder
+
+typedef struct {
+    pickupScale pickup;             // Phase elements, the RMS squared and its reciprocal
+#ifdef ELEMENT_RESIDUAL
+    pickupScale residual_pickup;
+#endif
+    twiddle_t cos_angle;            // Torque angle as a unit vector
+    twiddle_t sin_angle;
+    const rate_t *curve;            // Operate and reset row of curveRates
+    dial_t dial;                    // Time dial with the decision step folded in, see toDial
+    instantSetting instant;
+    restraintSetting restraint;
+} compiledSettings;
+
+typedef struct {
+    uint32_t applied;       // Changes published
+    uint32_t refused;       // Changes offered while one was still waiting
+    uint32_t switches;      // Group changes, from the inputs or from commands
+} settingsStats;
+
+extern settingsStats settings_stats;
+
+// The bank the decisions use, one pointer read
+extern const compiledSettings *volatile active_settings;
+
+static inline const compiledSettings *settingsActive(void){
+    return active_settings;
+}
+
+void settingsCompile(const relayType *relay, compiledSettings *out);
+
+// Compile every group and start in the one the inputs select, before the acquisition starts
+void settings_init(const relayType groups[SETTING_GROUPS]);
+
+// Compile a change of one group into the spare bank for the next power cycle, from the main loop
+// False while an earlier change still waits
+bool settingsApply(uint8_t group, const relayType *relay);
+
+// Switch to a group at the next power cycle, false if there is no such group
+bool settingsSelect(uint8_t group);
+
+// The group the decisions use
+uint8_t settingsGroup(void);
+
+// Follow the inputs and publish what is waiting, once a power cycle from the main loop
+void settingsCycle(void);
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+// Packed 16 bit helpers for the fixed point DFT
+// On the M4 these are the DSP extension instructions, everywhere else the
+// portable C below computes the same integer result bit for bit
+
+// Two neighbouring int16 values in one word, the first one in the low half
+typedef uint32_t packed16_t;
+
+// Load two int16 values as one word, memcpy becomes a single LDR on the M4
+// which handles the unaligned twiddle rows of the odd quarter cycle offsets
+static inline packed16_t loadPacked(const int16_t *p){
+    packed16_t word;
+    memcpy(&word, p, sizeof(word));
+    return word;
+}
+
+#if defined(__ARM_FEATURE_DSP) && __ARM_FEATURE_DSP
+
+// SMLALD, both halves multiplied and added to a 64 bit accumulator in one cycle
+static inline int64_t dualMac(int64_t acc, packed16_t x, packed16_t y){
+    return (int64_t)__SMLALD(x, y, (uint64_t)acc);
+}
+
+#else
+
+// Portable reference of SMLALD
+static inline int64_t dualMac(int64_t acc, packed16_t x, packed16_t y){
+    int32_t lo = (int32_t)(int16_t)(x & 0xFFFF) * (int16_t)(y & 0xFFFF);
+    int32_t hi = (int32_t)(int16_t)(x >> 16) * (int16_t)(y >> 16);
+    return acc + lo + hi;
+}
+
+#endif
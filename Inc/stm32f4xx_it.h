@@ -5,8 +5,15 @@
 extern TIM_HandleTypeDef adc_trigger;
 extern ADC_HandleTypeDef adc_handle;
 extern TIM_HandleTypeDef zero_handle;
+extern DMA_HandleTypeDef adc_dma_handle;
+extern UART_HandleTypeDef telemetry_uart;
+extern DMA_HandleTypeDef telemetry_dma;
 
 // Function prototypes for ISR handlers
 void ADC_IRQHandler(void);
-void TIM3_IRQHandler(void);
+void TIM2_IRQHandler(void);
+void DMA2_Stream0_IRQHandler(void);
+void EXTI0_IRQHandler(void);
+void DMA1_Stream6_IRQHandler(void);
+void USART2_IRQHandler(void);
 
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "relay_config.h"
+#include "relay_numeric.h"
+#include "dft.h"
+
+// Binary telemetry, one frame per power cycle out of USART2 (PA2) by DMA
+// The main loop only fills a snapshot buffer, the transfer runs on its own and a
+// frame that finds both buffers busy replaces the one still waiting, so protection
+// never waits on the UART. Decode with Sim/Tools/telemetry_decode
+
+// Frame layout, little endian
+//   uint8  sync 0xA5 0x5A
+//   uint8  version
+//   uint8  payload length
+//   uint16 sequence         +1 every frame, gaps are frames dropped on the board
+//   payload
+//   uint16 CRC-16/CCITT-FALSE of everything from the version up to the end of the payload
+// Payload
+//   uint32 period           g_current_period, 1MHz ticks per cycle
+//   uint8  channels
+//   uint8  elements
+//   uint8  state            TELEMETRY_TRIPPED | TELEMETRY_FORWARD | TELEMETRY_INSTANT | TELEMETRY_RESTRAINED,
+//                           the active setting group in TELEMETRY_GROUP
+//   uint8  tracking         frequencySource the period came from
+//   uint16 load             cpu_load.load of the last power cycle, permille
+//   uint16 trip_latency     latencyTripWorst, microseconds from the last sample to the trip
+//                           output at worst, 0 before the first trip or without RELAY_PROFILE
+//   float32 real, img       per channel, volts at the pin
+//   float32 psm2, progress  per element, PSM squared and the fraction of the trip
+//   uint8  flags            per element, TELEMETRY_PICKUP | TELEMETRY_FORWARD,
+//                           the polarSource of the direction in TELEMETRY_POLAR
+#define TELEMETRY_SYNC0 0xA5
+#define TELEMETRY_SYNC1 0x5A
+#define TELEMETRY_VERSION 3
+#define TELEMETRY_HEADER 6
+#define TELEMETRY_TRAILER 2
+
+#define TELEMETRY_TRIPPED 0x01
+#define TELEMETRY_INSTANT 0x04
+#define TELEMETRY_RESTRAINED 0x08
+#define TELEMETRY_GROUP_SHIFT 4
+#define TELEMETRY_GROUP   0x70
+#define TELEMETRY_PICKUP  0x01
+#define TELEMETRY_FORWARD 0x02
+#define TELEMETRY_POLAR_SHIFT 2
+#define TELEMETRY_POLAR   0x0C
+
+#define TELEMETRY_PAYLOAD (12 + ADC_CHANNELS * 8 + RELAY_ELEMENTS * 9)
+#define TELEMETRY_FRAME (TELEMETRY_HEADER + TELEMETRY_PAYLOAD + TELEMETRY_TRAILER)
+
+// CRC-16/CCITT-FALSE a nibble at a time, shared with the host decoder
+static inline uint16_t telemetryCrc(const uint8_t *data, uint32_t length){
+    static const uint16_t nibble[16] = {
+        0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+        0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+    };
+    uint16_t crc = 0xFFFF;
+    for(uint32_t i = 0; i < length; i++){
+        crc = (uint16_t)(crc << 4) ^ nibble[(crc >> 12) ^ (data[i] >> 4)];
+        crc = (uint16_t)(crc << 4) ^ nibble[(crc >> 12) ^ (data[i] & 0x0F)];
+    }
+    return crc;
+}
+
+// What the decision left of every element for the frame
+typedef struct {
+    psm2_t psm2;
+    progress_t progress;
+    uint8_t flags;
+} elementStatus;
+
+#if RELAY_TELEMETRY
+
+// Frames the main loop replaced before they went out
+extern volatile uint32_t telemetry_dropped;
+
+void telemetry_init(void);
+
+// Called after every decision, the one that ends a cycle is snapshot and queued
+// Only copies into RAM, never waits for the UART
+void telemetryDecision(const complexNum *phasors, const elementStatus *elements, bool tripped, bool forward);
+
+#else
+
+static inline void telemetry_init(void){}
+
+static inline void telemetryDecision(const complexNum *phasors, const elementStatus *elements, bool tripped, bool forward){
+    (void)phasors; (void)elements; (void)tripped; (void)forward;
+}
+
+#endif
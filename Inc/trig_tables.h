@@ -0,0 +1,65 @@
+#pragma once
+
+// Twiddle factors for every supported sample_times, one quarter wave longer than a cycle
+// so the cosine is the same table read N/4 entries later, sin(x + pi/2) = cos(x)
+// TWIDDLE() converts the literals for the numeric mode, so all of this is folded at compile time
+#if sample_times == 12
+#define TRIG_TABLE_VALUES \
+    TWIDDLE(0.0), TWIDDLE(0.5), TWIDDLE(0.8660254037844386), TWIDDLE(1.0), \
+    TWIDDLE(0.8660254037844386), TWIDDLE(0.5), TWIDDLE(0.0), TWIDDLE(-0.5), \
+    TWIDDLE(-0.8660254037844386), TWIDDLE(-1.0), TWIDDLE(-0.8660254037844386), TWIDDLE(-0.5), \
+    TWIDDLE(0.0), TWIDDLE(0.5), TWIDDLE(0.8660254037844386)
+#elif sample_times == 16
+#define TRIG_TABLE_VALUES \
+    TWIDDLE(0.0), TWIDDLE(0.3826834323650898), TWIDDLE(0.7071067811865475), TWIDDLE(0.9238795325112868), \
+    TWIDDLE(1.0), TWIDDLE(0.9238795325112868), TWIDDLE(0.7071067811865475), TWIDDLE(0.3826834323650898), \
+    TWIDDLE(0.0), TWIDDLE(-0.3826834323650898), TWIDDLE(-0.7071067811865475), TWIDDLE(-0.9238795325112868), \
+    TWIDDLE(-1.0), TWIDDLE(-0.9238795325112868), TWIDDLE(-0.7071067811865475), TWIDDLE(-0.3826834323650898), \
+    TWIDDLE(0.0), TWIDDLE(0.3826834323650898), TWIDDLE(0.7071067811865475), TWIDDLE(0.9238795325112868)
+#elif sample_times == 24
+#define TRIG_TABLE_VALUES \
+    TWIDDLE(0.0), TWIDDLE(0.2588190451025208), TWIDDLE(0.5), TWIDDLE(0.7071067811865475), \
+    TWIDDLE(0.8660254037844386), TWIDDLE(0.9659258262890683), TWIDDLE(1.0), TWIDDLE(0.9659258262890683), \
+    TWIDDLE(0.8660254037844386), TWIDDLE(0.7071067811865475), TWIDDLE(0.5), TWIDDLE(0.2588190451025208), \
+    TWIDDLE(0.0), TWIDDLE(-0.2588190451025208), TWIDDLE(-0.5), TWIDDLE(-0.7071067811865475), \
+    TWIDDLE(-0.8660254037844386), TWIDDLE(-0.9659258262890683), TWIDDLE(-1.0), TWIDDLE(-0.9659258262890683), \
+    TWIDDLE(-0.8660254037844386), TWIDDLE(-0.7071067811865475), TWIDDLE(-0.5), TWIDDLE(-0.2588190451025208), \
+    TWIDDLE(0.0), TWIDDLE(0.2588190451025208), TWIDDLE(0.5), TWIDDLE(0.7071067811865475), \
+    TWIDDLE(0.8660254037844386), TWIDDLE(0.9659258262890683)
+#elif sample_times == 32
+#define TRIG_TABLE_VALUES \
+    TWIDDLE(0.0), TWIDDLE(0.1950903220161283), TWIDDLE(0.3826834323650898), TWIDDLE(0.5555702330196022), \
+    TWIDDLE(0.7071067811865475), TWIDDLE(0.8314696123025452), TWIDDLE(0.9238795325112868), TWIDDLE(0.9807852804032304), \
+    TWIDDLE(1.0), TWIDDLE(0.9807852804032304), TWIDDLE(0.9238795325112868), TWIDDLE(0.8314696123025452), \
+    TWIDDLE(0.7071067811865475), TWIDDLE(0.5555702330196022), TWIDDLE(0.3826834323650898), TWIDDLE(0.1950903220161283), \
+    TWIDDLE(0.0), TWIDDLE(-0.1950903220161283), TWIDDLE(-0.3826834323650898), TWIDDLE(-0.5555702330196022), \
+    TWIDDLE(-0.7071067811865475), TWIDDLE(-0.8314696123025452), TWIDDLE(-0.9238795325112868), TWIDDLE(-0.9807852804032304), \
+    TWIDDLE(-1.0), TWIDDLE(-0.9807852804032304), TWIDDLE(-0.9238795325112868), TWIDDLE(-0.8314696123025452), \
+    TWIDDLE(-0.7071067811865475), TWIDDLE(-0.5555702330196022), TWIDDLE(-0.3826834323650898), TWIDDLE(-0.1950903220161283), \
+    TWIDDLE(0.0), TWIDDLE(0.1950903220161283), TWIDDLE(0.3826834323650898), TWIDDLE(0.5555702330196022), \
+    TWIDDLE(0.7071067811865475), TWIDDLE(0.8314696123025452), TWIDDLE(0.9238795325112868), TWIDDLE(0.9807852804032304)
+#elif sample_times == 64
+#define TRIG_TABLE_VALUES \
+    TWIDDLE(0.0), TWIDDLE(0.0980171403295606), TWIDDLE(0.1950903220161283), TWIDDLE(0.2902846772544624), \
+    TWIDDLE(0.3826834323650898), TWIDDLE(0.4713967368259976), TWIDDLE(0.5555702330196022), TWIDDLE(0.6343932841636455), \
+    TWIDDLE(0.7071067811865475), TWIDDLE(0.773010453362737), TWIDDLE(0.8314696123025452), TWIDDLE(0.881921264348355), \
+    TWIDDLE(0.9238795325112868), TWIDDLE(0.9569403357322089), TWIDDLE(0.9807852804032304), TWIDDLE(0.9951847266721969), \
+    TWIDDLE(1.0), TWIDDLE(0.9951847266721969), TWIDDLE(0.9807852804032304), TWIDDLE(0.9569403357322089), \
+    TWIDDLE(0.9238795325112868), TWIDDLE(0.881921264348355), TWIDDLE(0.8314696123025452), TWIDDLE(0.773010453362737), \
+    TWIDDLE(0.7071067811865475), TWIDDLE(0.6343932841636455), TWIDDLE(0.5555702330196022), TWIDDLE(0.4713967368259976), \
+    TWIDDLE(0.3826834323650898), TWIDDLE(0.2902846772544624), TWIDDLE(0.1950903220161283), TWIDDLE(0.0980171403295606), \
+    TWIDDLE(0.0), TWIDDLE(-0.0980171403295606), TWIDDLE(-0.1950903220161283), TWIDDLE(-0.2902846772544624), \
+    TWIDDLE(-0.3826834323650898), TWIDDLE(-0.4713967368259976), TWIDDLE(-0.5555702330196022), TWIDDLE(-0.6343932841636455), \
+    TWIDDLE(-0.7071067811865475), TWIDDLE(-0.773010453362737), TWIDDLE(-0.8314696123025452), TWIDDLE(-0.881921264348355), \
+    TWIDDLE(-0.9238795325112868), TWIDDLE(-0.9569403357322089), TWIDDLE(-0.9807852804032304), TWIDDLE(-0.9951847266721969), \
+    TWIDDLE(-1.0), TWIDDLE(-0.9951847266721969), TWIDDLE(-0.9807852804032304), TWIDDLE(-0.9569403357322089), \
+    TWIDDLE(-0.9238795325112868), TWIDDLE(-0.881921264348355), TWIDDLE(-0.8314696123025452), TWIDDLE(-0.773010453362737), \
+    TWIDDLE(-0.7071067811865475), TWIDDLE(-0.6343932841636455), TWIDDLE(-0.5555702330196022), TWIDDLE(-0.4713967368259976), \
+    TWIDDLE(-0.3826834323650898), TWIDDLE(-0.2902846772544624), TWIDDLE(-0.1950903220161283), TWIDDLE(-0.0980171403295606), \
+    TWIDDLE(0.0), TWIDDLE(0.0980171403295606), TWIDDLE(0.1950903220161283), TWIDDLE(0.2902846772544624), \
+    TWIDDLE(0.3826834323650898), TWIDDLE(0.4713967368259976), TWIDDLE(0.5555702330196022), TWIDDLE(0.6343932841636455), \
+    TWIDDLE(0.7071067811865475), TWIDDLE(0.773010453362737), TWIDDLE(0.8314696123025452), TWIDDLE(0.881921264348355), \
+    TWIDDLE(0.9238795325112868), TWIDDLE(0.9569403357322089), TWIDDLE(0.9807852804032304), TWIDDLE(0.9951847266721969)
+#else
+#error "sample_times must be one of 12, 16, 24, 32 or 64"
+#endif
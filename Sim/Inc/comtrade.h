@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// COMTRADE (IEEE C37.111) reader for the 1991, 1999 and 2013 revisions
+// ASCII, BINARY, BINARY32 and FLOAT32 data files, analog channels only
+// The writer produces 1999 ASCII records with timestamps instead of a sampling rate
+
+typedef struct {
+    char id[64];
+    char phase[16];
+    char units[16];
+    double a;            // value = a * raw + b in units
+    double b;
+    double skew;         // Seconds after the sample timestamp the channel was taken
+    double primary;
+    double secondary;
+    char ps;             // 'P' when the values are primary, 'S' when secondary
+} comtradeAnalog;
+
+typedef struct {
+    char station[64];
+    int revision;
+    int n_analog;
+    int n_digital;
+    comtradeAnalog *analog;
+    double frequency;    // Nominal line frequency
+    size_t n_samples;
+    double *time;        // Seconds from the first sample
+    float *value;        // n_samples rows of n_analog raw values, a and b not applied
+    double trigger;      // Trigger time in seconds from the first sample
+} comtradeRecord;
+
+// Read the .cfg and the .dat next to it, 0 on success or -1 with a message in err
+int comtradeLoad(const char *cfg_path, comtradeRecord *rec, char *err, size_t err_len);
+
+void comtradeFree(comtradeRecord *rec);
+
+// Write the .cfg and the .dat next to it, the values go out rounded to integers
+int comtradeSave(const char *cfg_path, const comtradeRecord *rec, char *err, size_t err_len);
+
+// A sample of a channel in secondary units, kV and kA scaled to V and A
+double comtradeSecondary(const comtradeRecord *rec, int channel, size_t sample);
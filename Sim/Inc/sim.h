@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Virtual hardware for the host build
+// The peripheral models run on virtual time and only advance when the firmware
+// has nothing left to do, so a replay runs as fast as the host can process it
+
+// Reference of the ADC and the analog front end, the pins swing 0 to SIM_VREF
+#define SIM_VREF 3.3
+
+// Core clock the virtual cycle counter runs at, what SystemClock_Config sets up
+#define SIM_CORE_HZ 84000000u
+
+// One change of a GPIO output
+typedef struct {
+    double time;
+    uint16_t pin;
+    bool high;
+} simEdge;
+
+// What the board sees, supplied by the replay
+typedef struct {
+    // Volts at the pin of an ADC input channel (ADC_CHANNEL_x) at time t
+    double (*pin_volts)(void *ctx, uint32_t adc_channel, double t);
+    // First rising edge of the zero crossing comparator after t, negative if there is none
+    double (*next_zero_cross)(void *ctx, double t);
+    // Every change of a GPIOA output as it happens, may be NULL
+    void (*output_edge)(void *ctx, const simEdge *edge);
+    // Level driven onto a GPIO input (port 0 for GPIOA), -1 leaves it to the pull, may be NULL
+    int (*input_level)(void *ctx, int port, int bit, double t);
+    // Bytes of a UART transfer once the last one has left the wire, may be NULL
+    void (*uart_tx)(void *ctx, const uint8_t *data, uint32_t length);
+    // Thread mode with nothing left to do before it sleeps, where the main loop would take
+    // a command, may be NULL
+    void (*thread_idle)(void *ctx, double t);
+    void *ctx;
+    // Virtual seconds to run for
+    double end;
+    // Virtual second an ADC overrun stops the DMA requests, negative for none
+    double overrun;
+    // Virtual second thread mode stops running for stall_for seconds, the interrupts go on
+    double stall;
+    double stall_for;
+} simInputs;
+
+// Load the inputs before calling the firmware main
+void simAttach(const simInputs *inputs);
+
+// Virtual seconds since reset
+double simTime(void);
+
+// Changes of the GPIOA outputs so far
+uint32_t simEdges(const simEdge **edges);
+
+// Called once the virtual time reaches the end, implemented by the replay front end
+void simFinish(void);
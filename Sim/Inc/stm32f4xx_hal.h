@@ -0,0 +1,430 @@
+#pragma once
+
+// Host stand in for the CMSIS device header and the STM32F4 HAL
+// Only what the firmware uses, the registers the firmware touches directly are
+// plain memory that the peripheral models in Sim/Src/sim_hal.c read and write
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define __IO volatile
+#define __weak __attribute__((weak))
+
+typedef enum { RESET = 0, SET = !RESET } FlagStatus;
+typedef enum { DISABLE = 0, ENABLE = !DISABLE } FunctionalState;
+typedef enum { HAL_OK, HAL_ERROR, HAL_BUSY, HAL_TIMEOUT } HAL_StatusTypeDef;
+
+// Registers, same names and order as the device header
+
+typedef struct {
+    __IO uint32_t MODER, OTYPER, OSPEEDR, PUPDR, IDR, ODR, BSRR, LCKR, AFR[2];
+} GPIO_TypeDef;
+
+typedef struct {
+    __IO uint32_t CR1, CR2, SMCR, DIER, SR, EGR, CCMR1, CCMR2, CCER, CNT, PSC, ARR, RCR, CCR1, CCR2, CCR3, CCR4;
+} TIM_TypeDef;
+
+typedef struct {
+    __IO uint32_t SR, CR1, CR2, SMPR1, SMPR2, JOFR[4], HTR, LTR, SQR1, SQR2, SQR3, JSQR, JDR[4], DR;
+} ADC_TypeDef;
+
+typedef struct {
+    __IO uint32_t CR, NDTR, PAR, M0AR, M1AR, FCR;
+} DMA_Stream_TypeDef;
+
+typedef struct {
+    __IO uint32_t SR, DR, BRR, CR1, CR2, CR3, GTPR;
+} USART_TypeDef;
+
+typedef struct {
+    __IO uint32_t CTRL, CYCCNT;
+} DWT_Type;
+
+typedef struct {
+    __IO uint32_t DHCSR, DCRSR, DCRDR, DEMCR;
+} CoreDebug_Type;
+
+extern GPIO_TypeDef sim_gpio[3];
+extern TIM_TypeDef sim_tim[5];
+extern ADC_TypeDef sim_adc;
+extern DMA_Stream_TypeDef sim_dma1[8];
+extern DMA_Stream_TypeDef sim_dma2[8];
+extern USART_TypeDef sim_usart2;
+extern DWT_Type sim_dwt;
+extern CoreDebug_Type sim_coredebug;
+
+// Addresses of the models, constant expressions like the real peripheral bases
+#define GPIOA (&sim_gpio[0])
+#define GPIOB (&sim_gpio[1])
+#define GPIOC (&sim_gpio[2])
+#define TIM2 (&sim_tim[1])
+#define TIM3 (&sim_tim[2])
+#define TIM4 (&sim_tim[3])
+#define TIM5 (&sim_tim[4])
+#define ADC1 (&sim_adc)
+#define DMA1_Stream6 (&sim_dma1[6])
+#define DMA2_Stream0 (&sim_dma2[0])
+#define USART2 (&sim_usart2)
+#define DWT (&sim_dwt)
+#define CoreDebug (&sim_coredebug)
+
+#define DWT_CTRL_CYCCNTENA_Msk (1u << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk (1u << 24)
+
+typedef enum {
+    SysTick_IRQn = -1,
+    EXTI0_IRQn = 6,
+    DMA1_Stream6_IRQn = 17,
+    ADC_IRQn = 18,
+    TIM2_IRQn = 28,
+    TIM3_IRQn = 29,
+    USART2_IRQn = 38,
+    DMA2_Stream0_IRQn = 56,
+    SIM_IRQ_COUNT = 96
+} IRQn_Type;
+
+extern uint32_t SystemCoreClock;
+
+// Compiler intrinsics
+
+#define __DSB() __sync_synchronize()
+#define __ISB() __sync_synchronize()
+#define __DMB() __sync_synchronize()
+
+// The simulated interrupts only run while the core sleeps, so masking them is a no-op
+// and WFI runs the peripherals up to their next event
+#define __disable_irq() ((void)0)
+#define __enable_irq() ((void)0)
+void __WFI(void);
+
+// GPIO
+
+#define GPIO_PIN_0  ((uint16_t)0x0001)
+#define GPIO_PIN_1  ((uint16_t)0x0002)
+#define GPIO_PIN_2  ((uint16_t)0x0004)
+#define GPIO_PIN_3  ((uint16_t)0x0008)
+#define GPIO_PIN_4  ((uint16_t)0x0010)
+#define GPIO_PIN_5  ((uint16_t)0x0020)
+#define GPIO_PIN_6  ((uint16_t)0x0040)
+#define GPIO_PIN_7  ((uint16_t)0x0080)
+#define GPIO_PIN_8  ((uint16_t)0x0100)
+#define GPIO_PIN_9  ((uint16_t)0x0200)
+#define GPIO_PIN_10 ((uint16_t)0x0400)
+#define GPIO_PIN_11 ((uint16_t)0x0800)
+#define GPIO_PIN_12 ((uint16_t)0x1000)
+#define GPIO_PIN_13 ((uint16_t)0x2000)
+#define GPIO_PIN_14 ((uint16_t)0x4000)
+#define GPIO_PIN_15 ((uint16_t)0x8000)
+
+typedef enum { GPIO_PIN_RESET = 0, GPIO_PIN_SET } GPIO_PinState;
+
+typedef struct {
+    uint32_t Pin;
+    uint32_t Mode;
+    uint32_t Pull;
+    uint32_t Speed;
+    uint32_t Alternate;
+} GPIO_InitTypeDef;
+
+#define GPIO_MODE_INPUT      0x00u
+#define GPIO_MODE_OUTPUT_PP  0x01u
+#define GPIO_MODE_AF_PP      0x02u
+#define GPIO_MODE_ANALOG     0x03u
+#define GPIO_NOPULL          0x00u
+#define GPIO_PULLUP          0x01u
+#define GPIO_PULLDOWN        0x02u
+#define GPIO_SPEED_FREQ_LOW       0x00u
+#define GPIO_SPEED_FREQ_MEDIUM    0x01u
+#define GPIO_SPEED_FREQ_HIGH      0x02u
+#define GPIO_SPEED_FREQ_VERY_HIGH 0x03u
+#define GPIO_SPEED_LOW  GPIO_SPEED_FREQ_LOW
+#define GPIO_SPEED_FAST GPIO_SPEED_FREQ_HIGH
+#define GPIO_AF1_TIM2 0x01u
+#define GPIO_AF2_TIM3 0x02u
+#define GPIO_AF2_TIM5 0x02u
+#define GPIO_AF7_USART2 0x07u
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init);
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+
+// DMA
+
+typedef struct {
+    uint32_t Channel;
+    uint32_t Direction;
+    uint32_t PeriphInc;
+    uint32_t MemInc;
+    uint32_t PeriphDataAlignment;
+    uint32_t MemDataAlignment;
+    uint32_t Mode;
+    uint32_t Priority;
+    uint32_t FIFOMode;
+} DMA_InitTypeDef;
+
+typedef struct __DMA_HandleTypeDef {
+    DMA_Stream_TypeDef *Instance;
+    DMA_InitTypeDef Init;
+    void *Parent;
+} DMA_HandleTypeDef;
+
+#define DMA_CHANNEL_0 0x00000000u
+#define DMA_CHANNEL_4 0x08000000u
+#define DMA_PERIPH_TO_MEMORY 0x00000000u
+#define DMA_MEMORY_TO_PERIPH 0x00000040u
+#define DMA_PINC_DISABLE 0x00000000u
+#define DMA_MINC_ENABLE 0x00000400u
+#define DMA_PDATAALIGN_BYTE 0x00000000u
+#define DMA_PDATAALIGN_HALFWORD 0x00000800u
+#define DMA_MDATAALIGN_BYTE 0x00000000u
+#define DMA_MDATAALIGN_HALFWORD 0x00002000u
+#define DMA_NORMAL 0x00000000u
+#define DMA_CIRCULAR 0x00000100u
+#define DMA_PRIORITY_LOW 0x00000000u
+#define DMA_PRIORITY_HIGH 0x00020000u
+#define DMA_FIFOMODE_DISABLE 0x00000000u
+
+#define __HAL_DMA_GET_COUNTER(h) ((h)->Instance->NDTR)
+
+#define __HAL_LINKDMA(parent, field, dma) do { (parent)->field = &(dma); (dma).Parent = (parent); } while(0)
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma);
+void HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma);
+
+// ADC
+
+typedef struct {
+    uint32_t ClockPrescaler;
+    uint32_t Resolution;
+    uint32_t DataAlign;
+    uint32_t ScanConvMode;
+    uint32_t EOCSelection;
+    uint32_t ContinuousConvMode;
+    uint32_t NbrOfConversion;
+    uint32_t DiscontinuousConvMode;
+    uint32_t NbrOfDiscConversion;
+    uint32_t ExternalTrigConv;
+    uint32_t ExternalTrigConvEdge;
+    uint32_t DMAContinuousRequests;
+} ADC_InitTypeDef;
+
+typedef struct {
+    ADC_TypeDef *Instance;
+    ADC_InitTypeDef Init;
+    DMA_HandleTypeDef *DMA_Handle;
+} ADC_HandleTypeDef;
+
+typedef struct {
+    uint32_t Channel;
+    uint32_t Rank;
+    uint32_t SamplingTime;
+    uint32_t Offset;
+} ADC_ChannelConfTypeDef;
+
+#define ADC_CHANNEL_0 0u
+#define ADC_CHANNEL_1 1u
+#define ADC_CHANNEL_2 2u
+#define ADC_CHANNEL_3 3u
+#define ADC_CHANNEL_4 4u
+#define ADC_CHANNEL_5 5u
+#define ADC_CHANNEL_6 6u
+#define ADC_CHANNEL_7 7u
+#define ADC_CHANNEL_8 8u
+#define ADC_CHANNEL_9 9u
+
+#define ADC_CLOCK_SYNC_PCLK_DIV2 0x00000000u
+#define ADC_CLOCK_SYNC_PCLK_DIV4 0x00010000u
+#define ADC_RESOLUTION_12B 0x00000000u
+#define ADC_RESOLUTION_10B 0x01000000u
+#define ADC_DATAALIGN_RIGHT 0x00000000u
+#define ADC_EOC_SEQ_CONV 0x00000000u
+#define ADC_EOC_SINGLE_CONV 0x00000001u
+#define ADC_EXTERNALTRIGCONV_T2_TRGO 0x06000000u
+#define ADC_EXTERNALTRIGCONV_T3_TRGO 0x08000000u
+#define ADC_EXTERNALTRIGCONVEDGE_RISING 0x10000000u
+#define ADC_SAMPLETIME_3CYCLES 0u
+#define ADC_SAMPLETIME_15CYCLES 1u
+#define ADC_SAMPLETIME_28CYCLES 2u
+#define ADC_SAMPLETIME_56CYCLES 3u
+#define ADC_SAMPLETIME_84CYCLES 4u
+#define ADC_IT_EOC 0x00000020u
+#define ADC_IT_OVR 0x04000000u
+#define ADC_FLAG_EOC 0x00000002u
+#define ADC_FLAG_OVR 0x00000020u
+
+#define __HAL_ADC_ENABLE(h) ((h)->Instance->CR2 |= 1u)
+#define __HAL_ADC_ENABLE_IT(h, it) ((h)->Instance->CR1 |= (it))
+#define __HAL_ADC_GET_FLAG(h, flag) (((h)->Instance->SR & (flag)) == (flag))
+#define __HAL_ADC_CLEAR_FLAG(h, flag) ((h)->Instance->SR &= ~(uint32_t)(flag))
+
+HAL_StatusTypeDef HAL_ADC_Init(ADC_HandleTypeDef *hadc);
+HAL_StatusTypeDef HAL_ADC_ConfigChannel(ADC_HandleTypeDef *hadc, ADC_ChannelConfTypeDef *sConfig);
+HAL_StatusTypeDef HAL_ADC_Start_IT(ADC_HandleTypeDef *hadc);
+HAL_StatusTypeDef HAL_ADC_Start_DMA(ADC_HandleTypeDef *hadc, uint32_t *pData, uint32_t Length);
+HAL_StatusTypeDef HAL_ADC_Stop_DMA(ADC_HandleTypeDef *hadc);
+uint32_t HAL_ADC_GetValue(ADC_HandleTypeDef *hadc);
+void HAL_ADC_IRQHandler(ADC_HandleTypeDef *hadc);
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc);
+void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef *hadc);
+void HAL_ADC_ErrorCallback(ADC_HandleTypeDef *hadc);
+
+// UART, transmit by DMA only
+
+typedef struct {
+    uint32_t BaudRate;
+    uint32_t WordLength;
+    uint32_t StopBits;
+    uint32_t Parity;
+    uint32_t Mode;
+    uint32_t HwFlowCtl;
+    uint32_t OverSampling;
+} UART_InitTypeDef;
+
+typedef struct __UART_HandleTypeDef {
+    USART_TypeDef *Instance;
+    UART_InitTypeDef Init;
+    DMA_HandleTypeDef *hdmatx;
+} UART_HandleTypeDef;
+
+#define UART_WORDLENGTH_8B 0x00000000u
+#define UART_STOPBITS_1 0x00000000u
+#define UART_PARITY_NONE 0x00000000u
+#define UART_MODE_TX 0x00000008u
+#define UART_HWCONTROL_NONE 0x00000000u
+#define UART_OVERSAMPLING_16 0x00000000u
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size);
+void HAL_UART_IRQHandler(UART_HandleTypeDef *huart);
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart);
+
+// TIM
+
+typedef struct {
+    uint32_t Prescaler;
+    uint32_t CounterMode;
+    uint32_t Period;
+    uint32_t ClockDivision;
+    uint32_t RepetitionCounter;
+    uint32_t AutoReloadPreload;
+} TIM_Base_InitTypeDef;
+
+typedef struct {
+    TIM_TypeDef *Instance;
+    TIM_Base_InitTypeDef Init;
+    uint32_t Channel;
+} TIM_HandleTypeDef;
+
+typedef struct {
+    uint32_t MasterOutputTrigger;
+    uint32_t MasterSlaveMode;
+} TIM_MasterConfigTypeDef;
+
+typedef struct {
+    uint32_t ICPolarity;
+    uint32_t ICSelection;
+    uint32_t ICPrescaler;
+    uint32_t ICFilter;
+} TIM_IC_InitTypeDef;
+
+#define TIM_CHANNEL_1 0x00u
+#define TIM_CHANNEL_2 0x04u
+#define TIM_CHANNEL_3 0x08u
+#define TIM_CHANNEL_4 0x0Cu
+#define TIM_COUNTERMODE_UP 0x00u
+#define TIM_CLOCKDIVISION_DIV1 0x00u
+#define TIM_AUTORELOAD_PRELOAD_DISABLE 0x00u
+#define TIM_AUTORELOAD_PRELOAD_ENABLE 0x80u
+#define TIM_TRGO_UPDATE 0x20u
+#define TIM_MASTERSLAVEMODE_DISABLE 0x00u
+#define TIM_INPUTCHANNELPOLARITY_RISING 0x00u
+#define TIM_ICSELECTION_DIRECTTI 0x01u
+#define TIM_ICPSC_DIV1 0x00u
+
+#define __HAL_TIM_SET_AUTORELOAD(h, v) do { (h)->Instance->ARR = (v); (h)->Init.Period = (v); } while(0)
+#define __HAL_TIM_GET_AUTORELOAD(h) ((h)->Instance->ARR)
+#define __HAL_TIM_GET_COUNTER(h) ((h)->Instance->CNT)
+
+HAL_StatusTypeDef HAL_TIM_Base_Init(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_Base_Start(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIMEx_MasterConfigSynchronization(TIM_HandleTypeDef *htim, TIM_MasterConfigTypeDef *sMasterConfig);
+HAL_StatusTypeDef HAL_TIM_IC_ConfigChannel(TIM_HandleTypeDef *htim, TIM_IC_InitTypeDef *sConfig, uint32_t Channel);
+HAL_StatusTypeDef HAL_TIM_IC_Start_IT(TIM_HandleTypeDef *htim, uint32_t Channel);
+uint32_t HAL_TIM_ReadCapturedValue(TIM_HandleTypeDef *htim, uint32_t Channel);
+void HAL_TIM_IRQHandler(TIM_HandleTypeDef *htim);
+void HAL_TIM_IC_CaptureCallback(TIM_HandleTypeDef *htim);
+
+// RCC, PWR and the core
+
+typedef struct {
+    uint32_t PLLState;
+    uint32_t PLLSource;
+    uint32_t PLLM;
+    uint32_t PLLN;
+    uint32_t PLLP;
+    uint32_t PLLQ;
+} RCC_PLLInitTypeDef;
+
+typedef struct {
+    uint32_t OscillatorType;
+    uint32_t HSEState;
+    uint32_t LSEState;
+    uint32_t HSIState;
+    uint32_t HSICalibrationValue;
+    uint32_t LSIState;
+    RCC_PLLInitTypeDef PLL;
+} RCC_OscInitTypeDef;
+
+typedef struct {
+    uint32_t ClockType;
+    uint32_t SYSCLKSource;
+    uint32_t AHBCLKDivider;
+    uint32_t APB1CLKDivider;
+    uint32_t APB2CLKDivider;
+} RCC_ClkInitTypeDef;
+
+#define RCC_OSCILLATORTYPE_HSI 0x02u
+#define RCC_HSI_ON 0x01u
+#define RCC_PLL_ON 0x02u
+#define RCC_PLLSOURCE_HSI 0x00u
+#define RCC_PLLP_DIV4 0x04u
+#define RCC_CLOCKTYPE_SYSCLK 0x01u
+#define RCC_CLOCKTYPE_HCLK 0x02u
+#define RCC_CLOCKTYPE_PCLK1 0x04u
+#define RCC_CLOCKTYPE_PCLK2 0x08u
+#define RCC_SYSCLKSOURCE_PLLCLK 0x02u
+#define RCC_SYSCLK_DIV1 0x00u
+#define RCC_HCLK_DIV1 0x00u
+#define RCC_HCLK_DIV2 0x1000u
+#define FLASH_LATENCY_2 0x02u
+#define PWR_REGULATOR_VOLTAGE_SCALE1 0xC000u
+#define SYSTICK_CLKSOURCE_HCLK 0x04u
+
+// Clock gates have nothing to gate here
+#define __HAL_RCC_GPIOA_CLK_ENABLE() ((void)0)
+#define __HAL_RCC_GPIOB_CLK_ENABLE() ((void)0)
+#define __HAL_RCC_GPIOC_CLK_ENABLE() ((void)0)
+#define __HAL_RCC_TIM2_CLK_ENABLE() ((void)0)
+#define __HAL_RCC_TIM3_CLK_ENABLE() ((void)0)
+#define __HAL_RCC_TIM5_CLK_ENABLE() ((void)0)
+#define __HAL_RCC_ADC1_CLK_ENABLE() ((void)0)
+#define __HAL_RCC_DMA1_CLK_ENABLE() ((void)0)
+#define __HAL_RCC_DMA2_CLK_ENABLE() ((void)0)
+#define __HAL_RCC_USART2_CLK_ENABLE() ((void)0)
+#define __HAL_RCC_PWR_CLK_ENABLE() ((void)0)
+#define __HAL_PWR_VOLTAGESCALING_CONFIG(x) ((void)(x))
+
+HAL_StatusTypeDef HAL_Init(void);
+HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef *RCC_OscInitStruct);
+HAL_StatusTypeDef HAL_RCC_ClockConfig(RCC_ClkInitTypeDef *RCC_ClkInitStruct, uint32_t FLatency);
+uint32_t HAL_RCC_GetHCLKFreq(void);
+void SystemCoreClockUpdate(void);
+uint32_t HAL_SYSTICK_Config(uint32_t TicksNumb);
+void HAL_SYSTICK_CLKSourceConfig(uint32_t CLKSource);
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t Delay);
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority);
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn);
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn);
+void HAL_NVIC_SetPendingIRQ(IRQn_Type IRQn);
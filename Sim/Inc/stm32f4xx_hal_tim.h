@@ -0,0 +1,4 @@
+#pragma once
+
+// Everything the host build needs is in the one HAL stand in
+#include "stm32f4xx_hal.h"
@@ -0,0 +1,441 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <strings.h>
+
+#include "comtrade.h"
+
+#define MAX_FIELDS 32
+#define MAX_RATES 16
+
+typedef struct {
+    char line[1024];
+    char *field[MAX_FIELDS];
+    int count;
+} cfgLine;
+
+static void fail(char *err, size_t err_len, const char *what, const char *detail){
+    snprintf(err, err_len, "%s%s%s", what, detail ? ": " : "", detail ? detail : "");
+}
+
+static char *trim(char *s){
+    while(isspace((unsigned char)*s)){
+        s++;
+    }
+    char *end = s + strlen(s);
+    while(end > s && isspace((unsigned char)end[-1])){
+        *--end = '\0';
+    }
+    return s;
+}
+
+// The next line of the .cfg split on commas, empty fields are kept
+static int readLine(FILE *f, cfgLine *l){
+    if(!fgets(l->line, sizeof(l->line), f)){
+        return -1;
+    }
+    l->count = 0;
+    char *p = l->line;
+    while(l->count < MAX_FIELDS){
+        char *comma = strchr(p, ',');
+        if(comma){
+            *comma = '\0';
+        }
+        l->field[l->count++] = trim(p);
+        if(!comma){
+            break;
+        }
+        p = comma + 1;
+    }
+    return 0;
+}
+
+static const char *field(const cfgLine *l, int i){
+    return i < l->count ? l->field[i] : "";
+}
+
+static double number(const cfgLine *l, int i, double fallback){
+    const char *s = field(l, i);
+    return *s ? atof(s) : fallback;
+}
+
+// Days since 1970 of a civil date
+static long civilDays(long y, long m, long d){
+    y -= m <= 2;
+    long era = (y >= 0 ? y : y - 399) / 400;
+    long yoe = y - era * 400;
+    long doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+// "dd/mm/yyyy" (mm/dd/yy in 1991) and "hh:mm:ss.ssssss" as seconds
+static double timestamp(const char *date, const char *time, int revision){
+    long p1 = 0, p2 = 0, year = 0, hour = 0, minute = 0;
+    double second = 0.0;
+    sscanf(date, "%ld/%ld/%ld", &p1, &p2, &year);
+    sscanf(time, "%ld:%ld:%lf", &hour, &minute, &second);
+    long day = revision >= 1999 ? p1 : p2;
+    long month = revision >= 1999 ? p2 : p1;
+    if(year < 100){
+        year += year < 70 ? 2000 : 1900;
+    }
+    return civilDays(year, month, day) * 86400.0 + hour * 3600.0 + minute * 60.0 + second;
+}
+
+typedef enum { DAT_ASCII, DAT_BINARY, DAT_BINARY32, DAT_FLOAT32 } datFormat;
+
+static FILE *openData(const char *cfg_path, const char *mode){
+    char path[1024];
+    size_t n = strlen(cfg_path);
+    if(n < 4 || n >= sizeof(path)){
+        return NULL;
+    }
+    memcpy(path, cfg_path, n + 1);
+    const char *ext[] = { ".dat", ".DAT" };
+    for(int i = 0; i < 2; i++){
+        memcpy(path + n - 4, ext[i], 4);
+        FILE *f = fopen(path, mode);
+        if(f){
+            return f;
+        }
+    }
+    return NULL;
+}
+
+static int readAscii(FILE *f, comtradeRecord *rec, uint32_t *stamps, size_t capacity){
+    static char line[16384];
+    size_t i = 0;
+    int na = rec->n_analog;
+    while(i < capacity && fgets(line, sizeof(line), f)){
+        char *p = line;
+        char *end;
+        strtoul(p, &end, 10);
+        if(end == p){
+            continue;
+        }
+        p = strchr(end, ',');
+        if(!p){
+            continue;
+        }
+        p++;
+        stamps[i] = (uint32_t)strtoul(p, &end, 10);
+        p = end;
+        for(int ch = 0; ch < na; ch++){
+            float prev = i ? rec->value[(i - 1) * na + ch] : 0.0f;
+            float v = prev;
+            if(p && *p == ','){
+                p++;
+                double d = strtod(p, &end);
+                // Empty fields and 99999 mark missing data
+                if(end != p && d != 99999.0){
+                    v = (float)d;
+                }
+                p = end;
+            }
+            rec->value[i * na + ch] = v;
+        }
+        i++;
+    }
+    return (int)i;
+}
+
+static int readBinary(FILE *f, comtradeRecord *rec, uint32_t *stamps, size_t capacity, datFormat format){
+    int na = rec->n_analog;
+    size_t width = format == DAT_BINARY ? 2 : 4;
+    size_t size = 8 + width * na + 2 * ((rec->n_digital + 15) / 16);
+    uint8_t *row = malloc(size);
+    size_t i = 0;
+    while(i < capacity && fread(row, 1, size, f) == size){
+        memcpy(&stamps[i], row + 4, 4);
+        for(int ch = 0; ch < na; ch++){
+            const uint8_t *p = row + 8 + width * ch;
+            float prev = i ? rec->value[(i - 1) * na + ch] : 0.0f;
+            float v;
+            if(format == DAT_BINARY){
+                int16_t raw;
+                memcpy(&raw, p, 2);
+                v = raw == INT16_MIN ? prev : raw;
+            } else if(format == DAT_BINARY32){
+                int32_t raw;
+                memcpy(&raw, p, 4);
+                v = raw == INT32_MIN ? prev : (float)raw;
+            } else {
+                memcpy(&v, p, 4);
+                if(isnan(v)){
+                    v = prev;
+                }
+            }
+            rec->value[i * na + ch] = v;
+        }
+        i++;
+    }
+    free(row);
+    return (int)i;
+}
+
+int comtradeLoad(const char *cfg_path, comtradeRecord *rec, char *err, size_t err_len){
+    memset(rec, 0, sizeof(*rec));
+    FILE *f = fopen(cfg_path, "r");
+    if(!f){
+        fail(err, err_len, "cannot open", cfg_path);
+        return -1;
+    }
+
+    cfgLine l;
+    int status = -1;
+    double rate[MAX_RATES];
+    long end_sample[MAX_RATES];
+    int n_rates = 0;
+
+    // Station, device and revision
+    if(readLine(f, &l)){
+        goto bad;
+    }
+    snprintf(rec->station, sizeof(rec->station), "%s", field(&l, 0));
+    rec->revision = l.count > 2 && *field(&l, 2) ? atoi(field(&l, 2)) : 1991;
+
+    // Channel counts, "TT,##A,##D"
+    if(readLine(f, &l)){
+        goto bad;
+    }
+    rec->n_analog = atoi(field(&l, 1));
+    rec->n_digital = atoi(field(&l, 2));
+    if(rec->n_analog <= 0){
+        fail(err, err_len, "no analog channels in", cfg_path);
+        goto out;
+    }
+    rec->analog = calloc(rec->n_analog, sizeof(comtradeAnalog));
+
+    for(int ch = 0; ch < rec->n_analog; ch++){
+        if(readLine(f, &l)){
+            goto bad;
+        }
+        comtradeAnalog *a = &rec->analog[ch];
+        snprintf(a->id, sizeof(a->id), "%s", field(&l, 1));
+        snprintf(a->phase, sizeof(a->phase), "%s", field(&l, 2));
+        snprintf(a->units, sizeof(a->units), "%s", field(&l, 4));
+        a->a = number(&l, 5, 1.0);
+        a->b = number(&l, 6, 0.0);
+        a->skew = number(&l, 7, 0.0) * 1e-6;
+        a->primary = number(&l, 10, 1.0);
+        a->secondary = number(&l, 11, 1.0);
+        a->ps = (char)toupper((unsigned char)*field(&l, 12));
+        if(a->ps != 'P'){
+            a->ps = 'S';
+        }
+    }
+    for(int ch = 0; ch < rec->n_digital; ch++){
+        if(readLine(f, &l)){
+            goto bad;
+        }
+    }
+
+    // Line frequency and the sampling rates
+    if(readLine(f, &l)){
+        goto bad;
+    }
+    rec->frequency = number(&l, 0, 50.0);
+    if(readLine(f, &l)){
+        goto bad;
+    }
+    n_rates = atoi(field(&l, 0));
+    if(n_rates > MAX_RATES){
+        fail(err, err_len, "too many sampling rates in", cfg_path);
+        goto out;
+    }
+    for(int r = 0; r < n_rates; r++){
+        if(readLine(f, &l)){
+            goto bad;
+        }
+        rate[r] = number(&l, 0, 0.0);
+        end_sample[r] = atol(field(&l, 1));
+    }
+    // No rates still has one "0,last sample" line, the times come from the timestamps
+    long last_sample = n_rates > 0 ? end_sample[n_rates - 1] : 0;
+    if(n_rates == 0){
+        if(readLine(f, &l)){
+            goto bad;
+        }
+        last_sample = atol(field(&l, 1));
+    }
+
+    // First sample and trigger times
+    double start, trigger;
+    if(readLine(f, &l)){
+        goto bad;
+    }
+    start = timestamp(field(&l, 0), field(&l, 1), rec->revision);
+    if(readLine(f, &l)){
+        goto bad;
+    }
+    trigger = timestamp(field(&l, 0), field(&l, 1), rec->revision);
+    rec->trigger = trigger - start;
+
+    // Data file type and the timestamp multiplier
+    datFormat format = DAT_ASCII;
+    if(readLine(f, &l)){
+        goto bad;
+    }
+    const char *type = field(&l, 0);
+    if(!strcasecmp(type, "BINARY")){
+        format = DAT_BINARY;
+    } else if(!strcasecmp(type, "BINARY32")){
+        format = DAT_BINARY32;
+    } else if(!strcasecmp(type, "FLOAT32")){
+        format = DAT_FLOAT32;
+    } else if(strcasecmp(type, "ASCII")){
+        fail(err, err_len, "unknown data file type", type);
+        goto out;
+    }
+    double time_mult = 1.0;
+    if(readLine(f, &l) == 0 && *field(&l, 0)){
+        time_mult = number(&l, 0, 1.0);
+    }
+
+    FILE *dat = openData(cfg_path, format == DAT_ASCII ? "r" : "rb");
+    if(!dat){
+        fail(err, err_len, "no .dat next to", cfg_path);
+        goto out;
+    }
+
+    // The last end sample when the rates are given, otherwise whatever the file holds
+    size_t capacity = last_sample > 0 ? (size_t)last_sample : 0;
+    if(!capacity){
+        fseek(dat, 0, SEEK_END);
+        long bytes = ftell(dat);
+        fseek(dat, 0, SEEK_SET);
+        capacity = (size_t)bytes / 8 + 1;
+    }
+    uint32_t *stamps = malloc(capacity * sizeof(uint32_t));
+    rec->value = malloc(capacity * rec->n_analog * sizeof(float));
+    int n = format == DAT_ASCII ? readAscii(dat, rec, stamps, capacity) : readBinary(dat, rec, stamps, capacity, format);
+    fclose(dat);
+    if(n < 2){
+        free(stamps);
+        fail(err, err_len, "no samples in the .dat of", cfg_path);
+        goto out;
+    }
+    rec->n_samples = (size_t)n;
+
+    // Sample times from the rate table when it has one, the timestamps are in microseconds otherwise
+    rec->time = malloc(rec->n_samples * sizeof(double));
+    if(n_rates > 0 && rate[0] > 0.0){
+        double t = 0.0;
+        int r = 0;
+        for(size_t i = 0; i < rec->n_samples; i++){
+            rec->time[i] = t;
+            while(r < n_rates - 1 && (long)(i + 1) >= end_sample[r]){
+                r++;
+            }
+            t += 1.0 / rate[r];
+        }
+    } else {
+        for(size_t i = 0; i < rec->n_samples; i++){
+            rec->time[i] = (stamps[i] - stamps[0]) * time_mult * 1e-6;
+        }
+    }
+    free(stamps);
+
+    status = 0;
+    goto out;
+
+bad:
+    fail(err, err_len, "truncated", cfg_path);
+out:
+    fclose(f);
+    if(status){
+        comtradeFree(rec);
+    }
+    return status;
+}
+
+void comtradeFree(comtradeRecord *rec){
+    free(rec->analog);
+    free(rec->time);
+    free(rec->value);
+    rec->analog = NULL;
+    rec->time = NULL;
+    rec->value = NULL;
+}
+
+// "dd/mm/yyyy,hh:mm:ss.ssssss" of seconds from the epoch
+static void writeStamp(FILE *f, double seconds){
+    long days = (long)floor(seconds / 86400.0);
+    double rest = seconds - days * 86400.0;
+    // Civil date of a day number, the inverse of civilDays
+    long z = days + 719468;
+    long era = (z >= 0 ? z : z - 146096) / 146097;
+    long doe = z - era * 146097;
+    long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    long mp = (5 * doy + 2) / 153;
+    long day = doy - (153 * mp + 2) / 5 + 1;
+    long month = mp + (mp < 10 ? 3 : -9);
+    long year = yoe + era * 400 + (month <= 2);
+    int hour = (int)(rest / 3600.0);
+    int minute = (int)((rest - hour * 3600.0) / 60.0);
+    double second = rest - hour * 3600.0 - minute * 60.0;
+    fprintf(f, "%02ld/%02ld/%04ld,%02d:%02d:%09.6f\r\n", day, month, year, hour, minute, second);
+}
+
+int comtradeSave(const char *cfg_path, const comtradeRecord *rec, char *err, size_t err_len){
+    FILE *f = fopen(cfg_path, "w");
+    if(!f){
+        fail(err, err_len, "cannot create", cfg_path);
+        return -1;
+    }
+    FILE *dat = openData(cfg_path, "w");
+    if(!dat){
+        fclose(f);
+        fail(err, err_len, "cannot create the .dat next to", cfg_path);
+        return -1;
+    }
+
+    int na = rec->n_analog;
+    fprintf(f, "%s,,1999\r\n", rec->station);
+    fprintf(f, "%d,%dA,0D\r\n", na, na);
+    for(int ch = 0; ch < na; ch++){
+        const comtradeAnalog *a = &rec->analog[ch];
+        fprintf(f, "%d,%s,%s,,%s,%.9g,%.9g,%.0f,-99999,99999,%g,%g,%c\r\n", ch + 1, a->id, a->phase, a->units,
+            a->a, a->b, a->skew * 1e6, a->primary, a->secondary, a->ps == 'P' ? 'P' : 'S');
+    }
+    fprintf(f, "%g\r\n", rec->frequency);
+    // No fixed rate, the times are in the timestamps
+    fprintf(f, "0\r\n0,%zu\r\n", rec->n_samples);
+    writeStamp(f, 0.0);
+    writeStamp(f, rec->trigger);
+    fprintf(f, "ASCII\r\n1\r\n");
+
+    for(size_t i = 0; i < rec->n_samples; i++){
+        fprintf(dat, "%zu,%.0f", i + 1, (rec->time[i] - rec->time[0]) * 1e6);
+        for(int ch = 0; ch < na; ch++){
+            fprintf(dat, ",%.0f", rec->value[i * na + ch]);
+        }
+        fprintf(dat, "\r\n");
+    }
+
+    int status = ferror(f) || ferror(dat) ? -1 : 0;
+    fclose(f);
+    fclose(dat);
+    if(status){
+        fail(err, err_len, "write failed", cfg_path);
+    }
+    return status;
+}
+
+double comtradeSecondary(const comtradeRecord *rec, int channel, size_t sample){
+    const comtradeAnalog *a = &rec->analog[channel];
+    double v = a->a * rec->value[sample * rec->n_analog + channel] + a->b;
+    if(a->units[0] == 'k' || a->units[0] == 'K'){
+        v *= 1000.0;
+    } else if(a->units[0] == 'm'){
+        v *= 0.001;
+    }
+    if(a->ps == 'P' && a->primary != 0.0){
+        v *= a->secondary / a->primary;
+    }
+    return v;
+}
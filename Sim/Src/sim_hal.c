@@ -0,0 +1,788 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "stm32f4xx_hal.h"
+#include "stm32f4xx_it.h"
+#include "acquisition.h"
+#include "latency.h"
+#include "relay_config.h"
+#include "sim.h"
+
+// Peripheral models of the board on virtual time
+// Interrupts are raised through the firmware's own handlers in Src/stm32f4xx_it.c,
+// they run to completion inside __WFI while the firmware sleeps. One raised inside a
+// handler of the same or a higher priority waits until that returns, like the NVIC
+
+GPIO_TypeDef sim_gpio[3];
+TIM_TypeDef sim_tim[5];
+ADC_TypeDef sim_adc;
+DMA_Stream_TypeDef sim_dma1[8];
+DMA_Stream_TypeDef sim_dma2[8];
+USART_TypeDef sim_usart2;
+DWT_Type sim_dwt;
+CoreDebug_Type sim_coredebug;
+
+uint32_t SystemCoreClock = 16000000u;
+
+static const simInputs *inputs;
+
+// Virtual seconds since reset
+static double now = 0.0;
+
+double simTime(void){
+    return now;
+}
+
+void simAttach(const simInputs *in){
+    inputs = in;
+}
+
+// The core's own clock. Asleep it waits for the event time, awake it runs ahead of it by
+// the cycles charged for the work since. Only the latency probes read it, the peripherals
+// and the pins stay on the event time, so the replays come out the same with any costs
+static double core = 0.0;
+
+static void coreCharge(uint32_t cycles){
+    if(core < now){
+        core = now;
+    }
+    core += (double)cycles / SIM_CORE_HZ;
+}
+
+// The cycle counter of the latency probes runs on the core clock
+uint32_t hostCycles(void){
+    return (uint32_t)(uint64_t)((core > now ? core : now) * SIM_CORE_HZ);
+}
+
+// Rough Cortex-M4F cycle counts of the work that ends at each probe, from the operations
+// in it and not measured. Double precision is done in software there
+#if RELAY_NUMERIC == RELAY_NUMERIC_DOUBLE
+#define SIM_ARITHMETIC 8
+#else
+#define SIM_ARITHMETIC 1
+#endif
+
+void hostStage(latencyStage stage){
+    switch(stage){
+    case LAT_ADC_ISR:
+        // The HAL handler down to the callback
+        coreCharge(60);
+        break;
+    case LAT_BUFFER:
+        // The scheduler and the unpacking, of a scan or of a cycle
+#if RELAY_DFT == RELAY_DFT_SLIDING
+        coreCharge(80 + 10 * ADC_CHANNELS);
+#else
+        coreCharge(80 + 6 * ADC_CHANNELS * sample_times);
+#endif
+        break;
+    case LAT_PHASOR:
+        // The mimic, the DFT and the calibration of every channel, two multiply
+        // accumulates a sample for the cycle DFT and a twiddled update for the sliding one
+#if RELAY_DFT == RELAY_DFT_SLIDING
+        coreCharge(SIM_ARITHMETIC * 60 * ADC_CHANNELS);
+#else
+        coreCharge(SIM_ARITHMETIC * (8 * sample_times + 60) * ADC_CHANNELS);
+#endif
+        break;
+    case LAT_DECISION:
+        // Magnitude, direction and the curve of every phase
+        coreCharge(SIM_ARITHMETIC * 400 * RELAY_PHASES);
+        break;
+    case LAT_TRIP:
+        // quickTrip is called from inside the decisions, the elements up to the one that
+        // tripped, all of them at worst
+        coreCharge(SIM_ARITHMETIC * 400 * RELAY_PHASES);
+        break;
+    default:
+        break;
+    }
+}
+
+static void acquisitionIdle(void);
+
+// NVIC, handlers of the interrupts the firmware uses
+
+static void (*const vectors[SIM_IRQ_COUNT])(void) = {
+    [ADC_IRQn] = ADC_IRQHandler,
+    [TIM2_IRQn] = TIM2_IRQHandler,
+    [DMA2_Stream0_IRQn] = DMA2_Stream0_IRQHandler,
+#if RELAY_TRIP_ISR
+    [EXTI0_IRQn] = EXTI0_IRQHandler,
+#endif
+#if RELAY_TELEMETRY
+    [DMA1_Stream6_IRQn] = DMA1_Stream6_IRQHandler,
+    [USART2_IRQn] = USART2_IRQHandler,
+#endif
+};
+
+static bool irq_enabled[SIM_IRQ_COUNT];
+static bool irq_pending[SIM_IRQ_COUNT];
+static uint8_t irq_priority[SIM_IRQ_COUNT];
+
+// Preemption priority of the handler running, thread mode is below all 16 levels
+#define THREAD_PRIORITY 16
+static int running_priority = THREAD_PRIORITY;
+
+// Handlers run so far, WFI sleeps through the events that raise none
+static uint32_t irq_served = 0;
+
+static bool canRun(IRQn_Type irq){
+    return irq_enabled[irq] && vectors[irq] && irq_priority[irq] < running_priority;
+}
+
+static void serve(IRQn_Type irq){
+    int outer = running_priority;
+    running_priority = irq_priority[irq];
+    irq_served++;
+    // Stacking on the way in and unstacking on the way out
+    coreCharge(12);
+    vectors[irq]();
+    coreCharge(12);
+    running_priority = outer;
+
+    // Tail chain whatever was held back and can run now, the highest priority first
+    while(1){
+        int next = -1;
+        for(int i = 0; i < SIM_IRQ_COUNT; i++){
+            if(irq_pending[i] && canRun((IRQn_Type)i) && (next < 0 || irq_priority[i] < irq_priority[next])){
+                next = i;
+            }
+        }
+        if(next < 0){
+            return;
+        }
+        irq_pending[next] = false;
+        serve((IRQn_Type)next);
+    }
+}
+
+static void raise(IRQn_Type irq){
+    if(canRun(irq)){
+        serve(irq);
+    } else {
+        irq_pending[irq] = true;
+    }
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority){
+    (void)SubPriority;
+    if(IRQn >= 0){
+        irq_priority[IRQn] = (uint8_t)PreemptPriority;
+    }
+}
+
+void HAL_NVIC_SetPendingIRQ(IRQn_Type IRQn){
+    raise(IRQn);
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn){
+    if(IRQn < 0){
+        return;
+    }
+    irq_enabled[IRQn] = true;
+    if(irq_pending[IRQn]){
+        irq_pending[IRQn] = false;
+        raise(IRQn);
+    }
+}
+
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn){
+    if(IRQn >= 0){
+        irq_enabled[IRQn] = false;
+    }
+}
+
+// RCC and the core, the clock tree is fixed at what SystemClock_Config asks for
+
+HAL_StatusTypeDef HAL_Init(void){
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef *RCC_OscInitStruct){
+    (void)RCC_OscInitStruct;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RCC_ClockConfig(RCC_ClkInitTypeDef *RCC_ClkInitStruct, uint32_t FLatency){
+    (void)RCC_ClkInitStruct; (void)FLatency;
+    return HAL_OK;
+}
+
+void SystemCoreClockUpdate(void){
+    SystemCoreClock = SIM_CORE_HZ;
+}
+
+uint32_t HAL_RCC_GetHCLKFreq(void){
+    return SystemCoreClock;
+}
+
+uint32_t HAL_SYSTICK_Config(uint32_t TicksNumb){
+    (void)TicksNumb;
+    return 0;
+}
+
+void HAL_SYSTICK_CLKSourceConfig(uint32_t CLKSource){
+    (void)CLKSource;
+}
+
+uint32_t HAL_GetTick(void){
+    return (uint32_t)(uint64_t)(now * 1000.0);
+}
+
+void HAL_Delay(uint32_t Delay){
+    double until = now + Delay / 1000.0;
+    while(now < until){
+        acquisitionIdle();
+    }
+}
+
+// GPIO, every change of a GPIOA output is logged with its virtual time
+
+#define MAX_EDGES 4096
+
+static simEdge edges[MAX_EDGES];
+static uint32_t edge_count = 0;
+static uint32_t gpioa_seen = 0;
+
+uint32_t simEdges(const simEdge **out){
+    *out = edges;
+    return edge_count;
+}
+
+// Fold BSRR writes into ODR and log what changed
+static void gpioSync(void){
+    uint32_t bsrr = GPIOA->BSRR;
+    if(bsrr){
+        GPIOA->ODR = (GPIOA->ODR | (bsrr & 0xFFFF)) & ~(bsrr >> 16);
+        GPIOA->BSRR = 0;
+    }
+
+    uint32_t changed = (GPIOA->ODR ^ gpioa_seen) & 0xFFFF;
+    for(uint16_t bit = 0; changed; bit++){
+        if(changed & (1u << bit)){
+            changed &= ~(1u << bit);
+            simEdge edge = { now, (uint16_t)(1u << bit), (GPIOA->ODR >> bit) & 1 };
+            if(edge_count < MAX_EDGES){
+                edges[edge_count++] = edge;
+            }
+            if(inputs->output_edge){
+                inputs->output_edge(inputs->ctx, &edge);
+            }
+        }
+    }
+    gpioa_seen = GPIOA->ODR;
+}
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init){
+    for(int bit = 0; bit < 16; bit++){
+        if(GPIO_Init->Pin & (1u << bit)){
+            GPIOx->MODER = (GPIOx->MODER & ~(3u << (2 * bit))) | ((GPIO_Init->Mode & 3u) << (2 * bit));
+            GPIOx->PUPDR = (GPIOx->PUPDR & ~(3u << (2 * bit))) | ((GPIO_Init->Pull & 3u) << (2 * bit));
+        }
+    }
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState){
+    if(PinState == GPIO_PIN_SET){
+        GPIOx->ODR |= GPIO_Pin;
+    } else {
+        GPIOx->ODR &= ~(uint32_t)GPIO_Pin;
+    }
+    gpioSync();
+}
+
+// What the replay drives onto the pin, otherwise its pull, a floating pin reads IDR
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin){
+    int bit = __builtin_ctz(GPIO_Pin);
+    int level = inputs->input_level ? inputs->input_level(inputs->ctx, (int)(GPIOx - sim_gpio), bit, now) : -1;
+    if(level < 0){
+        uint32_t pull = (GPIOx->PUPDR >> (2 * bit)) & 3u;
+        level = pull == GPIO_PULLUP ? 1 : pull == GPIO_PULLDOWN ? 0 : !!(GPIOx->IDR & GPIO_Pin);
+    }
+    return level ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+// Timers, the kernel clock of every timer is 84 MHz before the prescaler
+
+#define TIMER_CLOCK 84000000.0
+
+typedef struct {
+    TIM_TypeDef *regs;
+    uint32_t max;        // The counter width
+    bool running;
+    double tick;         // Seconds per count
+    double origin;       // When the counter was last 0
+    uint32_t arr;        // The reload the next update was scheduled with
+    double next_update;
+} simTimer;
+
+static simTimer timers[] = {
+    { TIM2, 0xFFFFFFFFu },
+    { TIM3, 0xFFFFu },
+    { TIM4, 0xFFFFu },
+    { TIM5, 0xFFFFFFFFu },
+};
+
+#define TIMER_COUNT (sizeof(timers) / sizeof(timers[0]))
+
+static simTimer *findTimer(TIM_TypeDef *regs){
+    for(uint32_t i = 0; i < TIMER_COUNT; i++){
+        if(timers[i].regs == regs){
+            return &timers[i];
+        }
+    }
+    return NULL;
+}
+
+static uint32_t timerCount(const simTimer *t, double at){
+    return (uint32_t)(uint64_t)floor((at - t->origin) / t->tick + 1e-9);
+}
+
+#define TIM_CR1_ARPE (1u << 7)
+
+// Start the next period, with preload this is when a new ARR takes effect
+static void timerUpdate(simTimer *t){
+    t->origin = t->next_update;
+    if(t->regs->CR1 & TIM_CR1_ARPE){
+        t->arr = t->regs->ARR;
+    }
+    t->next_update = t->origin + (t->arr + 1.0) * t->tick;
+}
+
+// Roll the counters up to now and follow ARR writes from the firmware, without
+// preload a reload below the count is missed and the counter runs the whole way
+// round first, like the hardware
+static void timersSync(void){
+    for(uint32_t i = 0; i < TIMER_COUNT; i++){
+        simTimer *t = &timers[i];
+        if(!t->running){
+            continue;
+        }
+        // Updates due now are events, only the ones in the past roll silently
+        while(t->next_update < now){
+            timerUpdate(t);
+        }
+        t->regs->CNT = timerCount(t, now);
+        if(!(t->regs->CR1 & TIM_CR1_ARPE) && t->regs->ARR != t->arr){
+            t->arr = t->regs->ARR;
+            if(t->regs->CNT > t->arr){
+                fprintf(stderr, "sim: %.6f s ARR %u written below CNT %u, the counter wraps\n", now, (unsigned)t->arr, (unsigned)t->regs->CNT);
+                t->next_update = t->origin + ((double)t->max + 1.0 + t->arr + 1.0) * t->tick;
+            } else {
+                t->next_update = t->origin + (t->arr + 1.0) * t->tick;
+            }
+        }
+    }
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Init(TIM_HandleTypeDef *htim){
+    htim->Instance->PSC = htim->Init.Prescaler;
+    htim->Instance->ARR = htim->Init.Period;
+    if(htim->Init.AutoReloadPreload == TIM_AUTORELOAD_PRELOAD_ENABLE){
+        htim->Instance->CR1 |= TIM_CR1_ARPE;
+    } else {
+        htim->Instance->CR1 &= ~TIM_CR1_ARPE;
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Start(TIM_HandleTypeDef *htim){
+    simTimer *t = findTimer(htim->Instance);
+    if(t){
+        t->running = true;
+        t->tick = (htim->Instance->PSC + 1.0) / TIMER_CLOCK;
+        t->origin = now;
+        t->arr = htim->Instance->ARR;
+        t->next_update = now + (t->arr + 1.0) * t->tick;
+        htim->Instance->CR1 |= 1u;
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIMEx_MasterConfigSynchronization(TIM_HandleTypeDef *htim, TIM_MasterConfigTypeDef *sMasterConfig){
+    htim->Instance->CR2 = sMasterConfig->MasterOutputTrigger;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_IC_ConfigChannel(TIM_HandleTypeDef *htim, TIM_IC_InitTypeDef *sConfig, uint32_t Channel){
+    (void)htim; (void)sConfig; (void)Channel;
+    return HAL_OK;
+}
+
+// The zero crossing comparator drives the capture channel the firmware starts
+static TIM_HandleTypeDef *capture_handle;
+static uint32_t capture_channel;
+static double next_cross = -1.0;
+
+HAL_StatusTypeDef HAL_TIM_IC_Start_IT(TIM_HandleTypeDef *htim, uint32_t Channel){
+    HAL_TIM_Base_Start(htim);
+    capture_handle = htim;
+    capture_channel = Channel;
+    next_cross = inputs->next_zero_cross(inputs->ctx, now);
+    return HAL_OK;
+}
+
+uint32_t HAL_TIM_ReadCapturedValue(TIM_HandleTypeDef *htim, uint32_t Channel){
+    switch(Channel){
+    case TIM_CHANNEL_1: return htim->Instance->CCR1;
+    case TIM_CHANNEL_2: return htim->Instance->CCR2;
+    case TIM_CHANNEL_3: return htim->Instance->CCR3;
+    default: return htim->Instance->CCR4;
+    }
+}
+
+// CC1IF to CC4IF
+#define TIM_SR_CCIF(channel) (1u << ((channel) / 4 + 1))
+
+void HAL_TIM_IRQHandler(TIM_HandleTypeDef *htim){
+    for(uint32_t channel = TIM_CHANNEL_1; channel <= TIM_CHANNEL_4; channel += 4){
+        if(htim->Instance->SR & TIM_SR_CCIF(channel)){
+            htim->Instance->SR &= ~TIM_SR_CCIF(channel);
+            htim->Channel = channel;
+            HAL_TIM_IC_CaptureCallback(htim);
+        }
+    }
+}
+
+static void captureEdge(void){
+    const simTimer *t = findTimer(capture_handle->Instance);
+    uint32_t count = timerCount(t, now);
+    switch(capture_channel){
+    case TIM_CHANNEL_1: capture_handle->Instance->CCR1 = count; break;
+    case TIM_CHANNEL_2: capture_handle->Instance->CCR2 = count; break;
+    case TIM_CHANNEL_3: capture_handle->Instance->CCR3 = count; break;
+    default: capture_handle->Instance->CCR4 = count; break;
+    }
+    capture_handle->Instance->SR |= TIM_SR_CCIF(capture_channel);
+    raise(capture_handle->Instance == TIM2 ? TIM2_IRQn : TIM3_IRQn);
+    next_cross = inputs->next_zero_cross(inputs->ctx, now);
+}
+
+__weak void HAL_TIM_IC_CaptureCallback(TIM_HandleTypeDef *htim){
+    (void)htim;
+}
+
+// ADC1 on the TRGO of its trigger timer, one conversion after the other in rank order
+
+#define ADC_CLOCK (TIMER_CLOCK / 2.0)
+#define ADC_SR_EOC (1u << 1)
+#define ADC_SR_OVR (1u << 5)
+
+static const uint16_t sample_cycles[8] = { 3, 15, 28, 56, 84, 112, 144, 480 };
+
+static ADC_HandleTypeDef *adc;
+static bool adc_running = false;
+static bool adc_dma = false;
+static uint32_t rank_channel[16];
+static uint32_t rank_sampling[16];
+
+// The sequence being converted, -1 when the ADC waits for a trigger
+static int conv_rank = -1;
+static double conv_done;
+
+static uint16_t *dma_buffer;
+static uint32_t dma_length;
+static uint32_t dma_pos;
+static uint32_t dma_flags;
+#define DMA_FLAG_HT 1u
+#define DMA_FLAG_TC 2u
+
+static uint32_t adcBits(void){
+    return adc->Init.Resolution == ADC_RESOLUTION_10B ? 10 : 12;
+}
+
+static double adcPrescale(void){
+    return adc->Init.ClockPrescaler == ADC_CLOCK_SYNC_PCLK_DIV4 ? 2.0 : 1.0;
+}
+
+// Sampling plus one clock per bit
+static double conversionTime(int rank){
+    return (sample_cycles[rank_sampling[rank] & 7] + adcBits()) * adcPrescale() / ADC_CLOCK;
+}
+
+HAL_StatusTypeDef HAL_ADC_Init(ADC_HandleTypeDef *hadc){
+    adc = hadc;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADC_ConfigChannel(ADC_HandleTypeDef *hadc, ADC_ChannelConfTypeDef *sConfig){
+    (void)hadc;
+    if(sConfig->Rank >= 1 && sConfig->Rank <= 16){
+        rank_channel[sConfig->Rank - 1] = sConfig->Channel;
+        rank_sampling[sConfig->Rank - 1] = sConfig->SamplingTime;
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADC_Start_IT(ADC_HandleTypeDef *hadc){
+    adc = hadc;
+    adc_running = true;
+    adc_dma = false;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADC_Start_DMA(ADC_HandleTypeDef *hadc, uint32_t *pData, uint32_t Length){
+    adc = hadc;
+    adc_running = true;
+    adc_dma = true;
+    dma_buffer = (uint16_t *)pData;
+    dma_length = Length;
+    dma_pos = 0;
+    hadc->DMA_Handle->Instance->NDTR = Length;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADC_Stop_DMA(ADC_HandleTypeDef *hadc){
+    (void)hadc;
+    adc_running = false;
+    conv_rank = -1;
+    return HAL_OK;
+}
+
+uint32_t HAL_ADC_GetValue(ADC_HandleTypeDef *hadc){
+    return hadc->Instance->DR;
+}
+
+void HAL_ADC_IRQHandler(ADC_HandleTypeDef *hadc){
+    if(hadc->Instance->SR & ADC_SR_EOC){
+        hadc->Instance->SR &= ~ADC_SR_EOC;
+        HAL_ADC_ConvCpltCallback(hadc);
+    }
+    if(hadc->Instance->SR & ADC_SR_OVR){
+        hadc->Instance->SR &= ~ADC_SR_OVR;
+        HAL_ADC_ErrorCallback(hadc);
+    }
+}
+
+__weak void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc){
+    (void)hadc;
+}
+
+__weak void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef *hadc){
+    (void)hadc;
+}
+
+__weak void HAL_ADC_ErrorCallback(ADC_HandleTypeDef *hadc){
+    (void)hadc;
+}
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma){
+    (void)hdma;
+    return HAL_OK;
+}
+
+void HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma){
+    // The UART stream needs nothing, its completion comes from the UART itself
+    if(hdma->Instance != DMA2_Stream0){
+        return;
+    }
+    ADC_HandleTypeDef *parent = hdma->Parent;
+    uint32_t flags = dma_flags;
+    dma_flags = 0;
+    if(flags & DMA_FLAG_HT){
+        HAL_ADC_ConvHalfCpltCallback(parent);
+    }
+    if(flags & DMA_FLAG_TC){
+        HAL_ADC_ConvCpltCallback(parent);
+    }
+}
+
+// USART2 sending a DMA transfer, done when the last stop bit is out
+
+#define USART_SR_TC (1u << 6)
+
+static UART_HandleTypeDef *uart;
+static const uint8_t *uart_data;
+static uint32_t uart_length;
+static double uart_done = -1.0;
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart){
+    uart = huart;
+    huart->Instance->BRR = huart->Init.BaudRate;
+    huart->Instance->SR = USART_SR_TC;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size){
+    if(uart_done >= 0.0){
+        return HAL_BUSY;
+    }
+    uart = huart;
+    uart_data = pData;
+    uart_length = Size;
+    // A start bit, eight data bits and a stop bit per byte
+    uart_done = now + Size * 10.0 / huart->Init.BaudRate;
+    huart->Instance->SR &= ~USART_SR_TC;
+    if(huart->hdmatx){
+        huart->hdmatx->Instance->NDTR = Size;
+    }
+    return HAL_OK;
+}
+
+void HAL_UART_IRQHandler(UART_HandleTypeDef *huart){
+    if(huart->Instance->SR & USART_SR_TC){
+        HAL_UART_TxCpltCallback(huart);
+    }
+}
+
+__weak void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart){
+    (void)huart;
+}
+
+static void uartComplete(void){
+    uart_done = -1.0;
+    if(uart->hdmatx){
+        uart->hdmatx->Instance->NDTR = 0;
+    }
+    if(inputs->uart_tx){
+        inputs->uart_tx(inputs->ctx, uart_data, uart_length);
+    }
+    uart->Instance->SR |= USART_SR_TC;
+    raise(USART2_IRQn);
+}
+
+static void adcTrigger(void){
+    if(!adc_running){
+        return;
+    }
+    if(conv_rank >= 0){
+        // A trigger during a sequence is ignored by the ADC
+        fprintf(stderr, "sim: %.6f s trigger lost, the previous scan is still converting\n", now);
+        return;
+    }
+    conv_rank = 0;
+    conv_done = now + conversionTime(0);
+}
+
+static void adcConversion(void){
+    int rank = conv_rank;
+    double sampled = now - adcBits() * adcPrescale() / ADC_CLOCK;
+    double volts = inputs->pin_volts(inputs->ctx, rank_channel[rank], sampled);
+
+    double full = (double)(1u << adcBits());
+    double code = floor(volts / SIM_VREF * full);
+    code = code < 0.0 ? 0.0 : code > full - 1.0 ? full - 1.0 : code;
+    adc->Instance->DR = (uint32_t)code;
+
+    if(rank + 1 < (int)adc->Init.NbrOfConversion){
+        conv_rank = rank + 1;
+        conv_done = now + conversionTime(conv_rank);
+    } else {
+        conv_rank = -1;
+    }
+
+    if(adc_dma){
+        dma_buffer[dma_pos++] = (uint16_t)adc->Instance->DR;
+        if(dma_pos == dma_length / 2){
+            dma_flags |= DMA_FLAG_HT;
+        }
+        if(dma_pos == dma_length){
+            dma_flags |= DMA_FLAG_TC;
+            dma_pos = 0;
+        }
+        adc->DMA_Handle->Instance->NDTR = dma_length - dma_pos;
+        if(dma_flags){
+            raise(DMA2_Stream0_IRQn);
+        }
+        // The end of the sequence still sets EOC, an interrupt only if the firmware asked
+        if(conv_rank < 0){
+            adc->Instance->SR |= ADC_SR_EOC;
+            if(adc->Instance->CR1 & ADC_IT_EOC){
+                raise(ADC_IRQn);
+            }
+        }
+    } else if(adc->Init.EOCSelection == ADC_EOC_SINGLE_CONV || conv_rank < 0){
+        adc->Instance->SR |= ADC_SR_EOC;
+        raise(ADC_IRQn);
+    }
+}
+
+// A conversion overwrote one the DMA had not moved, the DMA requests stop until the
+// firmware restarts the transfer. The sequence under way is lost
+static void adcOverrun(void){
+    adc_running = false;
+    conv_rank = -1;
+    adc->Instance->SR |= ADC_SR_OVR;
+    raise(ADC_IRQn);
+}
+
+// Thread mode is held up by something the firmware does not know about
+static bool threadStalled(void){
+    return inputs->stall_for > 0.0 && now >= inputs->stall && now < inputs->stall + inputs->stall_for;
+}
+
+// The core sleeps until an interrupt, timer updates and conversions that raise none pass by
+// In a stall the interrupts are served but thread mode only wakes once it is over
+void __WFI(void){
+    if(inputs->thread_idle){
+        inputs->thread_idle(inputs->ctx, now);
+    }
+    uint32_t served = irq_served;
+    while(irq_served == served || threadStalled()){
+        acquisitionIdle();
+    }
+}
+
+// Run the board up to its next event
+static void acquisitionIdle(void){
+    gpioSync();
+    timersSync();
+
+    simTimer *trigger = findTimer(adc && adc->Init.ExternalTrigConv == ADC_EXTERNALTRIGCONV_T3_TRGO ? TIM3 : TIM2);
+
+    // The earliest of the trigger timer, the ADC, the comparator and the UART
+    double next = inputs->end;
+    int source = 0;
+    if(trigger->running && trigger->next_update < next){
+        next = trigger->next_update;
+        source = 1;
+    }
+    if(conv_rank >= 0 && conv_done < next){
+        next = conv_done;
+        source = 2;
+    }
+    if(capture_handle && next_cross >= 0.0 && next_cross < next){
+        next = next_cross;
+        source = 3;
+    }
+    if(uart_done >= 0.0 && uart_done < next){
+        next = uart_done;
+        source = 4;
+    }
+    static bool overrun_done = false;
+    if(adc_running && adc_dma && !overrun_done && inputs->overrun >= 0.0 && inputs->overrun < next){
+        next = inputs->overrun < now ? now : inputs->overrun;
+        source = 5;
+    }
+
+    now = next;
+    timersSync();
+
+    switch(source){
+    case 1:
+        timerUpdate(trigger);
+        adcTrigger();
+        break;
+    case 2:
+        adcConversion();
+        break;
+    case 3:
+        captureEdge();
+        break;
+    case 4:
+        uartComplete();
+        break;
+    case 5:
+        overrun_done = true;
+        adcOverrun();
+        break;
+    default:
+        simFinish();
+        exit(0);
+    }
+
+    gpioSync();
+    timersSync();
+}
@@ -0,0 +1,423 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "stm32f4xx_hal.h"
+#include "acquisition.h"
+#include "recorder.h"
+#include "latency.h"
+#include "comtrade.h"
+#include "sim.h"
+
+// Replay a COMTRADE record through the firmware on the simulated board
+// Reports the trip instants relative to the record trigger, one line per record
+
+// The firmware main, renamed by the host build
+int relay_main(void);
+
+// Inputs of the board and the ADC channel each one is wired to
+typedef struct {
+    const char *name;
+    uint32_t adc_channel;
+    bool voltage;
+    char phase;
+} boardInput;
+
+static const boardInput board[] = {
+    { "IA", ADC_CHANNEL_0, false, 'A' },
+    { "VA", ADC_CHANNEL_1, true,  'A' },
+    { "IB", ADC_CHANNEL_4, false, 'B' },
+    { "VB", ADC_CHANNEL_5, true,  'B' },
+    { "IC", ADC_CHANNEL_6, false, 'C' },
+    { "VC", ADC_CHANNEL_7, true,  'C' },
+    { "IN", ADC_CHANNEL_8, false, 'N' },
+};
+
+#define BOARD_INPUTS (sizeof(board) / sizeof(board[0]))
+
+// Contacts on the setting group inputs, PB4 up, from a time on
+typedef struct {
+    double time;
+    unsigned code;
+} groupChange;
+
+#define MAX_GROUP_CHANGES 16
+
+typedef struct {
+    comtradeRecord rec;
+    const char *path;
+    int source[BOARD_INPUTS];   // COMTRADE channel of each input, -1 when not connected
+    double ct_gain;             // Pin volts per secondary amp
+    double vt_gain;             // Pin volts per secondary volt
+    double bias;                // Front end offset, the pins idle at mid rail
+    bool stop_on_trip;
+    bool no_zero_cross;         // The comparator output is dead, the relay tracks on the phasors
+    bool has_expect;
+    double expect_ms;           // NAN when the record must not trip
+    double tolerance_ms;
+    double overrun;             // When the ADC overruns, negative for never
+    double stall;               // When thread mode stalls, for stall_ms
+    double stall_ms;
+    double latency_max_us;      // Bound on the worst trip latency, 0 for none
+    const char *record_path;    // Where the disturbance recorder is dumped at the end
+    int telemetry_fd;           // The telemetry UART, -1 when not connected
+    groupChange groups[MAX_GROUP_CHANGES];
+    int group_changes;
+} replay;
+
+static replay run = {
+    .ct_gain = 0.1,
+    .vt_gain = 0.01,
+    .bias = SIM_VREF / 2.0,
+    .tolerance_ms = 5.0,
+    .overrun = -1.0,
+    .telemetry_fd = -1,
+};
+
+static simInputs inputs;
+
+// Index of the last sample at or before t
+static size_t sampleAt(const comtradeRecord *rec, double t){
+    size_t lo = 0;
+    size_t hi = rec->n_samples - 1;
+    if(t <= rec->time[0]){
+        return 0;
+    }
+    if(t >= rec->time[hi]){
+        return hi;
+    }
+    while(hi - lo > 1){
+        size_t mid = (lo + hi) / 2;
+        if(rec->time[mid] <= t){
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+// Linear interpolation of a channel in secondary units
+static double secondaryAt(const comtradeRecord *rec, int ch, double t){
+    t -= rec->analog[ch].skew;
+    size_t i = sampleAt(rec, t);
+    if(i + 1 >= rec->n_samples || t <= rec->time[i]){
+        return comtradeSecondary(rec, ch, i);
+    }
+    double f = (t - rec->time[i]) / (rec->time[i + 1] - rec->time[i]);
+    return comtradeSecondary(rec, ch, i) * (1.0 - f) + comtradeSecondary(rec, ch, i + 1) * f;
+}
+
+static double pinVolts(void *ctx, uint32_t adc_channel, double t){
+    replay *r = ctx;
+    for(uint32_t i = 0; i < BOARD_INPUTS; i++){
+        if(board[i].adc_channel == adc_channel){
+            if(r->source[i] < 0){
+                return r->bias;
+            }
+            double gain = board[i].voltage ? r->vt_gain : r->ct_gain;
+            return r->bias + gain * secondaryAt(&r->rec, r->source[i], t);
+        }
+    }
+    // Nothing wired to that pin
+    return 0.0;
+}
+
+// The comparator on VA, rising edges interpolated between the samples
+static double nextZeroCross(void *ctx, double t){
+    replay *r = ctx;
+    int ch = r->source[1];
+    if(ch < 0 || r->no_zero_cross){
+        return -1.0;
+    }
+    const comtradeRecord *rec = &r->rec;
+    double skew = rec->analog[ch].skew;
+    for(size_t i = sampleAt(rec, t - skew); i + 1 < rec->n_samples; i++){
+        double v0 = comtradeSecondary(rec, ch, i);
+        double v1 = comtradeSecondary(rec, ch, i + 1);
+        if(v0 < 0.0 && v1 >= 0.0){
+            double cross = rec->time[i] + (rec->time[i + 1] - rec->time[i]) * (-v0 / (v1 - v0)) + skew;
+            if(cross > t){
+                return cross;
+            }
+        }
+    }
+    return -1.0;
+}
+
+// The group contacts close to ground for the 1 bits of the code, the open ones are left to the pull up
+static int inputLevel(void *ctx, int port, int bit, double t){
+    const replay *r = ctx;
+    if(port != 1 || bit < 4 || bit >= 4 + GROUP_INPUTS){
+        return -1;
+    }
+    int level = -1;
+    for(int i = 0; i < r->group_changes && r->groups[i].time <= t; i++){
+        level = r->groups[i].code & (1u << (bit - 4)) ? 0 : -1;
+    }
+    return level;
+}
+
+// Match the inputs to the recorded channels on the phase and the units
+static void autoMap(replay *r){
+    for(uint32_t i = 0; i < BOARD_INPUTS; i++){
+        if(r->source[i] != -2){
+            continue;
+        }
+        r->source[i] = -1;
+        for(int ch = 0; ch < r->rec.n_analog; ch++){
+            const comtradeAnalog *a = &r->rec.analog[ch];
+            char phase = (char)toupper((unsigned char)a->phase[0]);
+            if(phase == 'L'){
+                phase = "?ABC"[a->phase[1] >= '1' && a->phase[1] <= '3' ? a->phase[1] - '0' : 0];
+            }
+            bool volts = strchr(a->units, 'V') || strchr(a->units, 'v');
+            if(phase == board[i].phase && volts == board[i].voltage){
+                r->source[i] = ch;
+                break;
+            }
+        }
+    }
+}
+
+static void usage(const char *argv0){
+    fprintf(stderr,
+        "usage: %s [options] record.cfg\n"
+        "  -c NAME=N        wire input NAME (IA VA IB VB IC VC IN) to analog channel N, 0 for none\n"
+        "  --ct V           pin volts per secondary amp (default %g)\n"
+        "  --vt V           pin volts per secondary volt (default %g)\n"
+        "  --bias V         front end offset (default %g)\n"
+        "  --stop           stop at the first trip\n"
+        "  --no-zc          leave the zero crossing comparator silent\n"
+        "  --expect MS      expected trip time after the trigger, 'none' for no trip\n"
+        "  --tolerance MS   allowed error of --expect (default %g)\n"
+        "  --record FILE    dump the disturbance recorder at the end, see record2comtrade\n"
+        "  --telemetry PATH write the telemetry UART to PATH, a file or the slave of telemetry_decode --pty\n"
+        "  --group T=G      close the setting group inputs on code G from T seconds into the record, repeatable\n"
+        "  --overrun T      overrun the ADC T seconds into the record, the DMA stops until the firmware restarts it\n"
+        "  --stall T=MS     hold up thread mode for MS milliseconds from T seconds into the record, the interrupts go on\n"
+        "  --latency-max US fail unless the worst trip latency is measured and at most US, needs RELAY_PROFILE\n"
+        "  --list           show the recorded channels and the wiring, then exit\n",
+        argv0, run.ct_gain, run.vt_gain, run.bias, run.tolerance_ms);
+    exit(2);
+}
+
+static int parseWire(const char *arg){
+    for(uint32_t i = 0; i < BOARD_INPUTS; i++){
+        size_t n = strlen(board[i].name);
+        if(!strncasecmp(arg, board[i].name, n) && arg[n] == '='){
+            run.source[i] = atoi(arg + n + 1) - 1;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static void listChannels(void){
+    const comtradeRecord *rec = &run.rec;
+    printf("%s: rev %d, %zu samples over %.3f s, trigger at %.3f s\n", run.path, rec->revision, rec->n_samples, rec->time[rec->n_samples - 1], rec->trigger);
+    for(int ch = 0; ch < rec->n_analog; ch++){
+        const comtradeAnalog *a = &rec->analog[ch];
+        const char *wired = "";
+        for(uint32_t i = 0; i < BOARD_INPUTS; i++){
+            if(run.source[i] == ch){
+                wired = board[i].name;
+            }
+        }
+        printf("  %2d %-20s ph %-3s %-4s %c  %s\n", ch + 1, a->id, a->phase, a->units, a->ps, wired);
+    }
+}
+
+// The recorder image as the debugger would read it off the board
+static void dumpRecorder(const char *path){
+#if RELAY_RECORDER
+    FILE *f = fopen(path, "wb");
+    if(!f || fwrite(&disturbance, sizeof(disturbance), 1, f) != 1){
+        fprintf(stderr, "cannot write %s\n", path);
+    }
+    if(f){
+        fclose(f);
+    }
+#else
+    fprintf(stderr, "%s: built without RELAY_RECORDER\n", path);
+#endif
+}
+
+void simFinish(void){
+    const simEdge *edges;
+    uint32_t count = simEdges(&edges);
+
+    double first_trip = NAN;
+    int trips = 0;
+    for(uint32_t i = 0; i < count; i++){
+        if(edges[i].pin == GPIO_PIN_3 && edges[i].high){
+            if(!trips){
+                first_trip = (edges[i].time - run.rec.trigger) * 1000.0;
+            }
+            trips++;
+        }
+    }
+
+    if(trips){
+        printf("%s\ttrip\t%.3f ms\t%d operation%s\n", run.path, first_trip, trips, trips > 1 ? "s" : "");
+    } else {
+        printf("%s\tno trip\n", run.path);
+    }
+
+    if(missed_cycles || dropped_scans){
+        printf("%s\tmissed %u cycles, dropped %u scans\n", run.path, (unsigned)missed_cycles, (unsigned)dropped_scans);
+    }
+
+    // On the sim's core clock, the costs of the work are estimates, see hostStage
+    uint32_t latency = latencyTripWorst();
+    if(RELAY_PROFILE && trips){
+        printf("%s\tworst trip latency %u us\n", run.path, (unsigned)latency);
+    }
+
+    if(run.record_path){
+        dumpRecorder(run.record_path);
+    }
+
+    int status = 0;
+    if(run.latency_max_us > 0.0 && (latency == 0 || latency > run.latency_max_us)){
+        fprintf(stderr, "%s: worst trip latency %u us, expected more than 0 and at most %g\n", run.path, (unsigned)latency, run.latency_max_us);
+        status = 1;
+    }
+    if(run.has_expect){
+        bool pass;
+        if(isnan(run.expect_ms)){
+            pass = !trips;
+        } else {
+            pass = trips && fabs(first_trip - run.expect_ms) <= run.tolerance_ms;
+        }
+        if(!pass){
+            fprintf(stderr, "%s: expected %s\n", run.path, isnan(run.expect_ms) ? "no trip" : "a trip");
+            status = 1;
+        }
+    }
+    fflush(stdout);
+    exit(status);
+}
+
+// The telemetry UART, open() so a pseudo terminal works as well as a file
+static void uartTx(void *ctx, const uint8_t *data, uint32_t length){
+    const replay *r = ctx;
+    while(length){
+        ssize_t n = write(r->telemetry_fd, data, length);
+        if(n <= 0){
+            return;
+        }
+        data += n;
+        length -= (uint32_t)n;
+    }
+}
+
+// Stop the replay at the first trip instead of running to the end of the record
+static void outputEdge(void *ctx, const simEdge *edge){
+    const replay *r = ctx;
+    if(r->stop_on_trip && edge->pin == GPIO_PIN_3 && edge->high){
+        simFinish();
+    }
+}
+
+int main(int argc, char **argv){
+    bool list = false;
+    for(uint32_t i = 0; i < BOARD_INPUTS; i++){
+        run.source[i] = -2;
+    }
+
+    for(int i = 1; i < argc; i++){
+        const char *a = argv[i];
+        bool more = i + 1 < argc;
+        if(!strcmp(a, "-c") && more){
+            if(parseWire(argv[++i])){
+                usage(argv[0]);
+            }
+        } else if(!strcmp(a, "--ct") && more){
+            run.ct_gain = atof(argv[++i]);
+        } else if(!strcmp(a, "--vt") && more){
+            run.vt_gain = atof(argv[++i]);
+        } else if(!strcmp(a, "--bias") && more){
+            run.bias = atof(argv[++i]);
+        } else if(!strcmp(a, "--stop")){
+            run.stop_on_trip = true;
+        } else if(!strcmp(a, "--no-zc")){
+            run.no_zero_cross = true;
+        } else if(!strcmp(a, "--expect") && more){
+            const char *v = argv[++i];
+            run.has_expect = true;
+            run.expect_ms = strcasecmp(v, "none") ? atof(v) : NAN;
+        } else if(!strcmp(a, "--tolerance") && more){
+            run.tolerance_ms = atof(argv[++i]);
+        } else if(!strcmp(a, "--record") && more){
+            run.record_path = argv[++i];
+        } else if(!strcmp(a, "--telemetry") && more){
+            const char *path = argv[++i];
+            run.telemetry_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_NOCTTY, 0644);
+            if(run.telemetry_fd < 0){
+                fprintf(stderr, "cannot open %s\n", path);
+                return 2;
+            }
+        } else if(!strcmp(a, "--group") && more){
+            char *eq;
+            double t = strtod(argv[++i], &eq);
+            if(*eq != '=' || run.group_changes == MAX_GROUP_CHANGES || (run.group_changes && t < run.groups[run.group_changes - 1].time)){
+                usage(argv[0]);
+            }
+            run.groups[run.group_changes++] = (groupChange){ t, (unsigned)atoi(eq + 1) };
+        } else if(!strcmp(a, "--overrun") && more){
+            run.overrun = atof(argv[++i]);
+        } else if(!strcmp(a, "--stall") && more){
+            char *eq;
+            run.stall = strtod(argv[++i], &eq);
+            if(*eq != '='){
+                usage(argv[0]);
+            }
+            run.stall_ms = atof(eq + 1);
+        } else if(!strcmp(a, "--latency-max") && more){
+            run.latency_max_us = atof(argv[++i]);
+        } else if(!strcmp(a, "--list")){
+            list = true;
+        } else if(a[0] == '-' || run.path){
+            usage(argv[0]);
+        } else {
+            run.path = a;
+        }
+    }
+    if(!run.path){
+        usage(argv[0]);
+    }
+
+    char err[256];
+    if(comtradeLoad(run.path, &run.rec, err, sizeof(err))){
+        fprintf(stderr, "%s\n", err);
+        return 2;
+    }
+    autoMap(&run);
+
+    if(list){
+        listChannels();
+        return 0;
+    }
+
+    inputs = (simInputs){
+        .pin_volts = pinVolts,
+        .next_zero_cross = nextZeroCross,
+        .output_edge = outputEdge,
+        .input_level = inputLevel,
+        .uart_tx = run.telemetry_fd >= 0 ? uartTx : NULL,
+        .ctx = &run,
+        .end = run.rec.time[run.rec.n_samples - 1],
+        .overrun = run.overrun,
+        .stall = run.stall,
+        .stall_for = run.stall_ms / 1000.0,
+    };
+    simAttach(&inputs);
+
+    relay_main();
+    return 0;
+}
@@ -0,0 +1,125 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "main.h"
+
+// Trip and reset times of the flash curve tables against the published formulas
+// Every case integrates the progress of one element held at a PSM the way protect()
+// does, one decision a step through curveLookup, scaleRate and stepProgress on the
+// numeric mode this is built with, or below pickup from full travel back to 0 through
+// resetLookup and unwindProgress, and compares the time with the curve
+// equation written out here from the standard, not from Src/curves.c, so a unit slip
+// in the tables shows up. Fixed point also fails on any table point that saturated
+// its rate_t. Exits with 1 if any case is off by more than the bound
+
+#define CYCLE_US 20000
+
+// Interpolation between the table points, and the last decision may overshoot by one
+// decision interval, which dominates the short CO resets
+#define BOUND_PCT 2.0
+
+typedef struct {
+    const char *name;
+    Curves curve;
+    double dial;        // TMS of IEC, TD of IEEE, time_delay / CURVE_BASE_DELAY of CO
+    double psm;
+    bool reset;         // Wind back from full travel instead of tripping
+    double expect_s;
+} curveCase;
+
+static double iec(double k, double a, double tms, double m){
+    return tms * k / (pow(m, a) - 1.0);
+}
+
+static double ieee(double a, double b, double p, double td, double m){
+    return td * (a / (pow(m, p) - 1.0) + b);
+}
+
+// Reset time of both standards from full travel, TR/(1 - M^2) at the dial
+static double reset(double tr, double dial, double m){
+    return dial * tr / (1.0 - m * m);
+}
+
+static psm2_t toPsm2(double psm){
+#if RELAY_NUMERIC == RELAY_NUMERIC_FIXED
+    return (psm2_t)lround(psm * psm * 65536.0);
+#else
+    return (psm2_t)(psm * psm);
+#endif
+}
+
+// Seconds until the progress reaches PROGRESS_TRIP at a steady PSM
+static double tripTime(Curves curve, double dial, double psm){
+    // As settingsCompile does, the dial scales the rate and so divides the time
+    rate_t rate = scaleRate(curveLookup(curveRates[curve], toPsm2(psm)), toDial(1.0 / dial));
+    progress_t progress = 0;
+    long decisions = 0;
+    while(progress < PROGRESS_TRIP){
+        progress = stepProgress(progress, rate, CYCLE_US);
+        decisions++;
+        if(decisions > 3600L * 50 * decision_times){
+            return INFINITY;
+        }
+    }
+    return decisions * (CYCLE_US / 1e6) / decision_times;
+}
+
+// Seconds until the progress is back at 0 from a trip at a steady PSM below pickup
+static double resetTime(Curves curve, double dial, double psm){
+    rate_t rate = scaleRate(resetLookup(curveRates[curve], toPsm2(psm)), toDial(1.0 / dial));
+    progress_t progress = PROGRESS_TRIP;
+    long decisions = 0;
+    while(progress > 0){
+        progress = unwindProgress(progress, rate, CYCLE_US);
+        decisions++;
+        if(decisions > 3600L * 50 * decision_times){
+            return INFINITY;
+        }
+    }
+    return decisions * (CYCLE_US / 1e6) / decision_times;
+}
+
+int main(void){
+    const curveCase cases[] = {
+        // IEC 60255-151 standard inverse at TMS 1 and twice pickup, 10.03 s
+        { "IEC SI", IEC_SI, 1.0, 2.0, false, iec(0.14, 0.02, 1.0, 2.0) },
+        { "IEC EI", IEC_EI, 0.5, 5.0, false, iec(80.0, 2.0, 0.5, 5.0) },
+        // IEEE C37.112 moderately inverse at TD 1 and twice pickup, 3.80 s
+        { "IEEE MI", IEEE_MI, 1.0, 2.0, false, ieee(0.0515, 0.1140, 0.02, 1.0, 2.0) },
+        { "IEEE VI", IEEE_VI, 2.0, 3.0, false, ieee(19.61, 0.4910, 2.0, 2.0, 3.0) },
+        // Westinghouse CO2 at the base time dial, T + K/(M - C) in ms
+        { "CO2", CO2, 1.0, 1.67, false, (111.99 + 735.0 / (1.67 - 0.675)) / 1000.0 },
+        // Reset from full travel, IEC SI at half pickup 18 s, IEEE VI with no current 10.8 s
+        { "IEC SI", IEC_SI, 1.0, 0.5, true, reset(13.5, 1.0, 0.5) },
+        { "IEEE VI", IEEE_VI, 0.5, 0.0, true, reset(21.6, 0.5, 0.0) },
+        // CO2 winds back over 323 ms from full travel with no current
+        { "CO2", CO2, 1.0, 0.0, true, reset(0.323, 1.0, 0.0) },
+    };
+
+    int failed = 0;
+#if RELAY_NUMERIC == RELAY_NUMERIC_FIXED
+    for(int c = 0; c < CURVE_COUNT; c++){
+        // A curve without a reset time resets at once on purpose
+        int points = ktable[c].constTR > 0.0 ? CURVE_ROW : CURVE_POINTS;
+        for(int i = 0; i < points; i++){
+            if(curveRates[c][i] == UINT32_MAX){
+                printf("curve %d point %d saturated, lower RATE_SHIFT\n", c, i);
+                failed = 1;
+            }
+        }
+    }
+#endif
+    printf("%d decisions a cycle of %d us, bound %g%%\n", decision_times, CYCLE_US, BOUND_PCT);
+    printf("curve     dial   psm  case   expect_s   time_s  error_pct\n");
+    for(size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++){
+        const curveCase *c = &cases[i];
+        double time = c->reset ? resetTime(c->curve, c->dial, c->psm) : tripTime(c->curve, c->dial, c->psm);
+        double error = (time - c->expect_s) / c->expect_s * 100.0;
+        bool ok = fabs(error) <= BOUND_PCT || fabs(time - c->expect_s) <= CYCLE_US / 1e6 / decision_times;
+        printf("%-8s %5.2f %5.2f %-5s %8.4f %8.4f %10.3f%s\n", c->name, c->dial, c->psm, c->reset ? "reset" : "trip",
+            c->expect_s, time, error, ok ? "" : "  FAIL");
+        failed |= !ok;
+    }
+    return failed;
+}
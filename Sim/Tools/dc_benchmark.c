@@ -0,0 +1,143 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "main.h"
+
+// Settling of the phasor magnitude under a decaying DC offset, the plain correlation
+// against the mimic filter, on the DFT and the filter code of the firmware in the numeric
+// mode it is built with. A case is a sine of --amplitude codes around mid rail switched on
+// at an inception angle, with the full offset that angle leaves decaying at the time
+// constant of the case. The estimate is the full cycle DFT of the last sample_times
+// samples at every sample, the same magnitude the sliding DFT gives. Every row is the
+// worst over inception angles 0 to 165 degrees
+//   settle  time after inception until the magnitude stays in the band for good, ms
+//   peak    largest error from one cycle after inception on, percent
+// A step needs close to a whole cycle through the DFT alone, 20 ms at 50 Hz
+
+#define CYCLE_US 20000
+#define PRE_CYCLES 4
+#define ANGLES 12
+
+static void usage(const char *argv0){
+    fprintf(stderr,
+        "usage: %s [options]\n"
+        "  --tau MS        time constant the mimic is designed for (default %d)\n"
+        "  --band PCT      settling band around the true magnitude (default 5)\n"
+        "  --cycles N      cycles simulated after inception (default 12)\n"
+        "  --amplitude C   peak of the fault in ADC codes, twice that with the offset (default 200)\n",
+        argv0, DC_TAU_MS);
+    exit(2);
+}
+
+typedef struct {
+    double settle_ms;
+    double peak_pct;
+} caseResult;
+
+// One inception angle and offset through one estimator
+static caseResult runCase(const mimicFilter *filter, double amplitude, double tau_ms, double angle, int cycles, double band){
+    int total = (PRE_CYCLES + cycles) * sample_times;
+    int inception = PRE_CYCLES * sample_times;
+    double sample_ms = CYCLE_US / 1000.0 / sample_times;
+    double truth = amplitude * (ADC_VREF / ADC_FULL_SCALE) * PHASOR_PER_VOLT;
+    double bias = (ADC_FULL_SCALE + 1.0) / 2.0;
+
+    sample_t ring[sample_times] = {0};
+    sample_t window[sample_times];
+    sample_t last = 0;
+    caseResult result = { 0.0, 0.0 };
+    int last_outside = inception;
+
+    for(int n = 0; n < total; n++){
+        double value = 0.0;
+        if(n >= inception){
+            double t = (n - inception) * sample_ms;
+            double phase = 2.0 * M_PI * t / 20.0 + angle;
+            value = amplitude * sin(phase);
+            if(tau_ms > 0.0){
+                value -= amplitude * sin(angle) * exp(-t / tau_ms);
+            }
+        }
+        long code = lround(bias + value);
+        code = code < 0 ? 0 : code > (long)ADC_FULL_SCALE ? (long)ADC_FULL_SCALE : code;
+        sample_t x = toSample((uint32_t)code);
+        if(n == 0){
+            last = x;
+        }
+        sample_t y = filter ? mimicStep(filter, x, last) : x;
+        last = x;
+        ring[n % sample_times] = y;
+
+        if(n < inception){
+            continue;
+        }
+        // Oldest first, the magnitude does not care where the twiddles start
+        for(int i = 0; i < sample_times; i++){
+            window[i] = ring[(n + 1 + i) % sample_times];
+        }
+        complexNum phasor = getFiltered(window, COS_TABLE, SIN_TABLE);
+        double magnitude = hypot((double)phasor.real, (double)phasor.img);
+        double error = fabs(magnitude - truth) / truth * 100.0;
+        if(error > band){
+            last_outside = n + 1;
+        }
+        if(n >= inception + sample_times && error > result.peak_pct){
+            result.peak_pct = error;
+        }
+    }
+    result.settle_ms = (last_outside - inception) * sample_ms;
+    if(last_outside >= total){
+        result.settle_ms = INFINITY;
+    }
+    return result;
+}
+
+int main(int argc, char **argv){
+    double design_ms = DC_TAU_MS;
+    double band = 5.0;
+    int cycles = 12;
+    double amplitude = 200.0;
+
+    for(int i = 1; i < argc; i++){
+        const char *a = argv[i];
+        bool more = i + 1 < argc;
+        if(!strcmp(a, "--tau") && more){
+            design_ms = atof(argv[++i]);
+        } else if(!strcmp(a, "--band") && more){
+            band = atof(argv[++i]);
+        } else if(!strcmp(a, "--cycles") && more){
+            cycles = atoi(argv[++i]);
+        } else if(!strcmp(a, "--amplitude") && more){
+            amplitude = atof(argv[++i]);
+        } else {
+            usage(argv[0]);
+        }
+    }
+    if(cycles < 2 || design_ms <= 0.0 || amplitude <= 0.0 || 2.0 * amplitude > ADC_FULL_SCALE / 2.0){
+        usage(argv[0]);
+    }
+
+    mimicFilter filter;
+    mimicDesign(&filter, design_ms, CYCLE_US);
+
+    static const double offsets_ms[] = { 0.0, 10.0, 20.0, 40.0, 80.0, 160.0 };
+    printf("%d samples a cycle, mimic for %g ms, %g%% band, %d cycles\n", sample_times, design_ms, band, cycles);
+    printf("offset_ms  plain_settle_ms  plain_peak_pct  mimic_settle_ms  mimic_peak_pct\n");
+    for(size_t k = 0; k < sizeof(offsets_ms) / sizeof(offsets_ms[0]); k++){
+        caseResult plain = { 0.0, 0.0 };
+        caseResult mimic = { 0.0, 0.0 };
+        for(int a = 0; a < ANGLES; a++){
+            double angle = M_PI * a / ANGLES;
+            caseResult p = runCase(NULL, amplitude, offsets_ms[k], angle, cycles, band);
+            caseResult m = runCase(&filter, amplitude, offsets_ms[k], angle, cycles, band);
+            plain.settle_ms = fmax(plain.settle_ms, p.settle_ms);
+            plain.peak_pct = fmax(plain.peak_pct, p.peak_pct);
+            mimic.settle_ms = fmax(mimic.settle_ms, m.settle_ms);
+            mimic.peak_pct = fmax(mimic.peak_pct, m.peak_pct);
+        }
+        printf("%9g  %15.1f  %14.1f  %15.1f  %14.1f\n", offsets_ms[k], plain.settle_ms, plain.peak_pct, mimic.settle_ms, mimic.peak_pct);
+    }
+    return 0;
+}
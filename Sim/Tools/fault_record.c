@@ -0,0 +1,114 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+
+#include "comtrade.h"
+
+// Synthetic one phase fault record for the replay, IA and VA in secondary units
+// Load current up to the trigger, then a fault current lagging the voltage by --lag
+// with the DC offset its inception angle leaves, decaying at --tau. The voltage stays
+// up through the fault so the direction is always decided on it
+
+#define RATE_HZ 4000.0
+#define LOAD_AMPS 1.0
+#define LOAD_LAG_RAD 0.5
+#define VOLTS 63.5
+
+static void usage(const char *argv0){
+    fprintf(stderr,
+        "usage: %s [options] out.cfg\n"
+        "  --amps A        fault current, RMS secondary amps (default 10)\n"
+        "  --lag DEG       fault current behind the voltage, 180 more for a reverse fault (default 11)\n"
+        "  --tau MS        time constant of the DC offset, 0 for none (default 0)\n"
+        "  --pre S         load before the fault (default 0.2)\n"
+        "  --length S      whole record (default 1.5)\n"
+        "  --freq HZ       line frequency (default 50)\n",
+        argv0);
+    exit(2);
+}
+
+int main(int argc, char **argv){
+    double amps = 10.0;
+    double lag = 11.0;
+    double tau_ms = 0.0;
+    double pre = 0.2;
+    double length = 1.5;
+    double freq = 50.0;
+    const char *out_path = NULL;
+    for(int i = 1; i < argc; i++){
+        const char *a = argv[i];
+        bool more = i + 1 < argc;
+        if(!strcmp(a, "--amps") && more){
+            amps = atof(argv[++i]);
+        } else if(!strcmp(a, "--lag") && more){
+            lag = atof(argv[++i]);
+        } else if(!strcmp(a, "--tau") && more){
+            tau_ms = atof(argv[++i]);
+        } else if(!strcmp(a, "--pre") && more){
+            pre = atof(argv[++i]);
+        } else if(!strcmp(a, "--length") && more){
+            length = atof(argv[++i]);
+        } else if(!strcmp(a, "--freq") && more){
+            freq = atof(argv[++i]);
+        } else if(a[0] == '-' || out_path){
+            usage(argv[0]);
+        } else {
+            out_path = a;
+        }
+    }
+    if(!out_path || amps < 0.0 || pre <= 0.0 || length <= pre || freq <= 0.0){
+        usage(argv[0]);
+    }
+
+    comtradeRecord rec = { .revision = 1999, .n_analog = 2, .frequency = freq, .trigger = pre };
+    snprintf(rec.station, sizeof(rec.station), "OC_Relay synthetic");
+    rec.n_samples = (size_t)(length * RATE_HZ);
+    rec.analog = calloc(2, sizeof(comtradeAnalog));
+    rec.time = malloc(rec.n_samples * sizeof(double));
+    rec.value = malloc(rec.n_samples * 2 * sizeof(float));
+
+    // mA and cV steps, well under the ADC's own
+    static const struct { const char *id; const char *units; double a; } channels[] = {
+        { "IA", "A", 0.001 }, { "VA", "V", 0.01 },
+    };
+    for(int ch = 0; ch < 2; ch++){
+        comtradeAnalog *c = &rec.analog[ch];
+        snprintf(c->id, sizeof(c->id), "%s", channels[ch].id);
+        snprintf(c->phase, sizeof(c->phase), "A");
+        snprintf(c->units, sizeof(c->units), "%s", channels[ch].units);
+        c->a = channels[ch].a;
+        c->primary = 1.0;
+        c->secondary = 1.0;
+        c->ps = 'S';
+    }
+
+    double w = 2.0 * M_PI * freq;
+    double phase = -lag * M_PI / 180.0;
+    // The offset that makes the current continuous through the inception
+    double offset = amps * M_SQRT2 * sin(w * pre + phase);
+    for(size_t i = 0; i < rec.n_samples; i++){
+        double t = i / RATE_HZ;
+        double current;
+        if(t < pre){
+            current = LOAD_AMPS * M_SQRT2 * sin(w * t - LOAD_LAG_RAD);
+        } else {
+            current = amps * M_SQRT2 * sin(w * t + phase);
+            if(tau_ms > 0.0){
+                current -= offset * exp(-(t - pre) * 1000.0 / tau_ms);
+            }
+        }
+        rec.time[i] = t;
+        rec.value[i * 2] = (float)lround(current / channels[0].a);
+        rec.value[i * 2 + 1] = (float)lround(VOLTS * M_SQRT2 * sin(w * t) / channels[1].a);
+    }
+
+    char err[256];
+    if(comtradeSave(out_path, &rec, err, sizeof(err))){
+        fprintf(stderr, "%s\n", err);
+        return 2;
+    }
+    comtradeFree(&rec);
+    return 0;
+}
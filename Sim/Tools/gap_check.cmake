@@ -0,0 +1,77 @@
+# Trip times across the gaps of the DMA acquisition, an overrun restart and a main loop
+# held up for long enough that the DMA laps it. Run by ctest, see Sim/CMakeLists.txt
+#   cmake -DFAULT_RECORD=... -DREPLAY=... -DDECISION_US=... -DWORK_DIR=... -P gap_check.cmake
+# A gap may hold the trip back by its own length and the cycle the windows take to fill
+# again, never more and never bring it forward. A stall shorter than the buffer loses nothing
+
+set(CYCLE_US 20000)
+set(REPLAY_OPTIONS --stop --group 0=2)
+
+# Name, gap options, the longest the gap itself holds the trip back in us, the cycles
+# missed and whether the DMA laps the main loop. A lap misses those cycles at least and
+# loses scans where the decisions are taken on them, the other gaps exactly those cycles
+set(GAPS
+    "overrun:--overrun 0.3:0:1:no"
+    "short_stall:--stall 0.3=15:0:0:no"
+    "lap:--stall 0.3=45:45000:2:yes"
+    "long_lap:--stall 0.25=100:100000:4:yes"
+)
+
+foreach(var FAULT_RECORD REPLAY DECISION_US WORK_DIR)
+    if(NOT ${var})
+        message(FATAL_ERROR "gap_check needs -D${var}")
+    endif()
+endforeach()
+file(MAKE_DIRECTORY ${WORK_DIR})
+
+# Trip time of a replay in us and what it printed
+function(replay_trip result output options)
+    separate_arguments(options)
+    execute_process(COMMAND ${REPLAY} ${REPLAY_OPTIONS} ${options} ${cfg} OUTPUT_VARIABLE out RESULT_VARIABLE status)
+    if(NOT status EQUAL 0)
+        message(FATAL_ERROR "${REPLAY} ${options} ${cfg} exited with ${status}")
+    endif()
+    if(NOT out MATCHES "\ttrip\t([0-9]+)\\.([0-9][0-9][0-9]) ms")
+        message(FATAL_ERROR "${REPLAY} ${options} ${cfg}: no trip\n${out}")
+    endif()
+    math(EXPR us "${CMAKE_MATCH_1} * 1000 + ${CMAKE_MATCH_2}")
+    set(${result} ${us} PARENT_SCOPE)
+    set(${output} "${out}" PARENT_SCOPE)
+endfunction()
+
+# Picked up at 7.5 A by the maintenance group, a trip a few hundred ms in
+set(cfg ${WORK_DIR}/fault.cfg)
+execute_process(COMMAND ${FAULT_RECORD} --amps 10.5 ${cfg} RESULT_VARIABLE status)
+if(NOT status EQUAL 0)
+    message(FATAL_ERROR "fault_record ${cfg} exited with ${status}")
+endif()
+replay_trip(reference out "")
+
+foreach(gap ${GAPS})
+    string(REPLACE ":" ";" parts "${gap}")
+    list(GET parts 0 name)
+    list(GET parts 1 options)
+    list(GET parts 2 hold_us)
+    list(GET parts 3 missed_least)
+    list(GET parts 4 lap)
+    replay_trip(time out "${options}")
+    math(EXPR bound "${reference} + ${hold_us} + 2 * ${CYCLE_US} + ${DECISION_US}")
+    if(time LESS reference OR time GREATER bound)
+        message(SEND_ERROR "${name}: ${time} us, ${reference} us without the gap, up to ${bound} us allowed")
+    else()
+        message(STATUS "${name}: ${time} us, ${reference} us without the gap")
+    endif()
+    set(missed 0)
+    set(dropped 0)
+    if(out MATCHES "missed ([0-9]+) cycles, dropped ([0-9]+) scans")
+        set(missed ${CMAKE_MATCH_1})
+        set(dropped ${CMAKE_MATCH_2})
+    endif()
+    if(lap)
+        if(missed LESS missed_least OR (DECISION_US LESS CYCLE_US AND dropped EQUAL 0))
+            message(SEND_ERROR "${name}: missed ${missed} cycles and dropped ${dropped} scans, a lap misses ${missed_least} cycles at least\n${out}")
+        endif()
+    elseif(NOT missed EQUAL missed_least OR NOT dropped EQUAL 0)
+        message(SEND_ERROR "${name}: missed ${missed} cycles and dropped ${dropped} scans, expected ${missed_least} cycles and no scans\n${out}")
+    endif()
+endforeach()
@@ -0,0 +1,76 @@
+# Trip times of FLOAT and FIXED against DOUBLE on the same synthetic records
+# Run by ctest with the replays of the three numeric modes, see Sim/CMakeLists.txt
+#   cmake -DFAULT_RECORD=... -DDOUBLE=... -DFLOAT=... -DFIXED=... -DDECISION_US=... -DWORK_DIR=... -P numeric_check.cmake
+# Every record is written by fault_record and replayed in the maintenance group, whose
+# pickup the front end reaches, with the replay stopping at the first trip. A mode fails
+# when it trips where DOUBLE does not or the other way round, or when its trip time is
+# further from DOUBLE's than the bound
+
+# A decision either way plus 0.5% of the time for the interpolation and the rounding
+set(BOUND_PCT_TENTHS 5)
+set(REPLAY_OPTIONS --stop --group 0=2)
+
+# Name and fault_record options, the maintenance group picks up at 7.5 A
+set(RECORDS
+    "psm_1.2:--amps 9"
+    "psm_1.4:--amps 10.5"
+    "offset:--amps 9 --tau 40"
+    "off_nominal:--amps 10 --freq 51"
+    "below_pickup:--amps 6.5"
+    "reverse:--amps 10.5 --lag 191"
+)
+
+foreach(var FAULT_RECORD DOUBLE FLOAT FIXED DECISION_US WORK_DIR)
+    if(NOT ${var})
+        message(FATAL_ERROR "numeric_check needs -D${var}")
+    endif()
+endforeach()
+file(MAKE_DIRECTORY ${WORK_DIR})
+
+# Trip time of a replay in us, -1 for no trip
+function(replay_trip result replay cfg)
+    execute_process(COMMAND ${replay} ${REPLAY_OPTIONS} ${cfg} OUTPUT_VARIABLE out RESULT_VARIABLE status)
+    if(NOT status EQUAL 0)
+        message(FATAL_ERROR "${replay} ${cfg} exited with ${status}")
+    endif()
+    if(out MATCHES "\ttrip\t([0-9]+)\\.([0-9][0-9][0-9]) ms")
+        math(EXPR us "${CMAKE_MATCH_1} * 1000 + ${CMAKE_MATCH_2}")
+    elseif(out MATCHES "\tno trip")
+        set(us -1)
+    else()
+        message(FATAL_ERROR "${replay} ${cfg}: unexpected output\n${out}")
+    endif()
+    set(${result} ${us} PARENT_SCOPE)
+endfunction()
+
+foreach(record ${RECORDS})
+    string(REPLACE ":" ";" parts "${record}")
+    list(GET parts 0 name)
+    list(GET parts 1 options)
+    separate_arguments(options)
+    set(cfg ${WORK_DIR}/${name}.cfg)
+    execute_process(COMMAND ${FAULT_RECORD} ${options} ${cfg} RESULT_VARIABLE status)
+    if(NOT status EQUAL 0)
+        message(FATAL_ERROR "fault_record ${options} ${cfg} exited with ${status}")
+    endif()
+
+    replay_trip(reference ${DOUBLE} ${cfg})
+    foreach(mode FLOAT FIXED)
+        replay_trip(time ${${mode}} ${cfg})
+        if(reference LESS 0 OR time LESS 0)
+            if(reference EQUAL time)
+                message(STATUS "${name} ${mode}: no trip, as DOUBLE")
+            else()
+                message(SEND_ERROR "${name} ${mode}: ${time} us, DOUBLE ${reference} us, -1 is no trip")
+            endif()
+            continue()
+        endif()
+        math(EXPR error "${time} - ${reference}")
+        math(EXPR bound "${DECISION_US} + ${reference} * ${BOUND_PCT_TENTHS} / 1000")
+        if(error GREATER bound OR error LESS -${bound})
+            message(SEND_ERROR "${name} ${mode}: ${time} us, DOUBLE ${reference} us, more than ${bound} us apart")
+        else()
+            message(STATUS "${name} ${mode}: ${time} us, DOUBLE ${reference} us")
+        endif()
+    endforeach()
+endforeach()
@@ -0,0 +1,204 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "recorder.h"
+#include "comtrade.h"
+
+// Decompress a disturbance recorder dump into a COMTRADE record
+// The dump is the recorderImage as it sits in RAM, e.g. from gdb
+//   dump binary memory rec.bin &disturbance (char *)&disturbance + sizeof(disturbance)
+// or from the replay with --record. Both sides are little endian with the same
+// fixed width header, so it is read back as it is
+
+// Board inputs in rank order, see the CH_ defines
+static const struct {
+    const char *id;
+    const char *phase;
+    int voltage;
+} inputs_1ph[] = { { "IA", "A", 0 }, { "VA", "A", 1 } },
+  inputs_3ph[] = { { "IA", "A", 0 }, { "VA", "A", 1 }, { "IB", "B", 0 }, { "VB", "B", 1 }, { "IC", "C", 0 }, { "VC", "C", 1 }, { "IN", "N", 0 } };
+
+typedef struct {
+    const uint8_t *ring;
+    uint32_t mask;
+    uint32_t pos;
+    uint32_t acc;
+    uint32_t bits;
+} bitReader;
+
+static uint32_t getBits(bitReader *r, uint32_t n){
+    while(r->bits < n){
+        r->acc |= (uint32_t)r->ring[r->pos++ & r->mask] << r->bits;
+        r->bits += 8;
+    }
+    uint32_t value = r->acc & ((1u << n) - 1);
+    r->acc >>= n;
+    r->bits -= n;
+    return value;
+}
+
+static int32_t unzigzag(uint32_t z){
+    return (int32_t)(z >> 1) ^ -(int32_t)(z & 1);
+}
+
+static void usage(const char *argv0){
+    fprintf(stderr,
+        "usage: %s [options] dump.bin out.cfg\n"
+        "  --ct V      pin volts per secondary amp (default 0.1)\n"
+        "  --vt V      pin volts per secondary volt (default 0.01)\n"
+        "  --bias V    front end offset (default 1.65)\n"
+        "  --vref V    ADC reference (default 3.3)\n"
+        "  --freq HZ   nominal line frequency (default 50)\n",
+        argv0);
+    exit(2);
+}
+
+int main(int argc, char **argv){
+    double ct_gain = 0.1, vt_gain = 0.01, bias = 1.65, vref = 3.3, frequency = 50.0;
+    const char *in_path = NULL;
+    const char *out_path = NULL;
+
+    for(int i = 1; i < argc; i++){
+        const char *a = argv[i];
+        bool more = i + 1 < argc;
+        if(!strcmp(a, "--ct") && more){
+            ct_gain = atof(argv[++i]);
+        } else if(!strcmp(a, "--vt") && more){
+            vt_gain = atof(argv[++i]);
+        } else if(!strcmp(a, "--bias") && more){
+            bias = atof(argv[++i]);
+        } else if(!strcmp(a, "--vref") && more){
+            vref = atof(argv[++i]);
+        } else if(!strcmp(a, "--freq") && more){
+            frequency = atof(argv[++i]);
+        } else if(a[0] == '-' || (in_path && out_path)){
+            usage(argv[0]);
+        } else if(!in_path){
+            in_path = a;
+        } else {
+            out_path = a;
+        }
+    }
+    if(!in_path || !out_path){
+        usage(argv[0]);
+    }
+
+    FILE *f = fopen(in_path, "rb");
+    if(!f){
+        fprintf(stderr, "cannot open %s\n", in_path);
+        return 2;
+    }
+    recorderHeader h;
+    if(fread(&h, sizeof(h), 1, f) != 1 || h.magic != RECORDER_MAGIC){
+        fprintf(stderr, "%s: not a recorder dump\n", in_path);
+        return 2;
+    }
+    if(h.state != RECORDER_DONE || !h.cycles){
+        fprintf(stderr, "%s: the recorder has not been triggered\n", in_path);
+        return 1;
+    }
+    if(!h.capacity || (h.capacity & (h.capacity - 1)) || h.length > h.capacity || !h.channels || h.channels > 16 || h.samples < 2){
+        fprintf(stderr, "%s: corrupt header\n", in_path);
+        return 2;
+    }
+    uint8_t *ring = malloc(h.capacity);
+    if(fread(ring, 1, h.capacity, f) != h.capacity){
+        fprintf(stderr, "%s: truncated\n", in_path);
+        return 2;
+    }
+    fclose(f);
+
+    comtradeRecord rec = { .revision = 1999, .n_analog = h.channels, .frequency = frequency };
+    snprintf(rec.station, sizeof(rec.station), "OC_Relay %s", h.cause == RECORDER_CAUSE_TRIP ? "trip" : "pickup");
+    rec.n_samples = (size_t)h.cycles * h.samples;
+    rec.analog = calloc(h.channels, sizeof(comtradeAnalog));
+    rec.time = malloc(rec.n_samples * sizeof(double));
+    rec.value = malloc(rec.n_samples * h.channels * sizeof(float));
+
+    // The raw codes go out as they are, a and b scale them to secondary units
+    double lsb = vref / (double)(1u << h.adc_bits);
+    for(int ch = 0; ch < h.channels; ch++){
+        comtradeAnalog *a = &rec.analog[ch];
+        double gain = 1.0;
+        if(h.channels == 2 || h.channels == 6 || h.channels == 7){
+            bool voltage = h.channels == 2 ? inputs_1ph[ch].voltage : inputs_3ph[ch].voltage;
+            snprintf(a->id, sizeof(a->id), "%s", h.channels == 2 ? inputs_1ph[ch].id : inputs_3ph[ch].id);
+            snprintf(a->phase, sizeof(a->phase), "%s", h.channels == 2 ? inputs_1ph[ch].phase : inputs_3ph[ch].phase);
+            snprintf(a->units, sizeof(a->units), "%s", voltage ? "V" : "A");
+            gain = voltage ? vt_gain : ct_gain;
+        } else {
+            // Unknown wiring, pin volts
+            snprintf(a->id, sizeof(a->id), "CH%d", ch + 1);
+            snprintf(a->units, sizeof(a->units), "V");
+        }
+        a->a = lsb / gain;
+        a->b = -bias / gain;
+        a->primary = 1.0;
+        a->secondary = 1.0;
+        a->ps = 'S';
+    }
+
+    bitReader r = { .ring = ring, .mask = h.capacity - 1 };
+    uint32_t pos = h.start;
+    uint32_t used = 0;
+    double t = 0.0;
+    size_t row = 0;
+    for(int c = 0; c < h.cycles; c++){
+        r.pos = pos;
+        r.acc = 0;
+        r.bits = 0;
+        uint32_t length = getBits(&r, 8) | getBits(&r, 8) << 8;
+        uint32_t period = getBits(&r, 8) | getBits(&r, 8) << 8;
+        if(length <= RECORDER_BLOCK_HEADER || used + length > h.length){
+            fprintf(stderr, "%s: corrupt block %d\n", in_path, c);
+            return 2;
+        }
+        if(c == h.pre_cycles){
+            rec.trigger = t;
+        }
+
+        uint8_t width[16] = {0};
+        for(int ch = 0; ch < h.channels; ch++){
+            width[ch] = (uint8_t)getBits(&r, 4);
+        }
+        if(h.channels & 1){
+            getBits(&r, 4);
+        }
+        for(int ch = 0; ch < h.channels; ch++){
+            int32_t code = (int32_t)getBits(&r, h.adc_bits);
+            rec.value[row * h.channels + ch] = (float)code;
+            for(int i = 1; i < h.samples; i++){
+                if(width[ch]){
+                    code += unzigzag(getBits(&r, width[ch]));
+                }
+                rec.value[(row + i) * h.channels + ch] = (float)code;
+            }
+        }
+
+        // The scans of a cycle are evenly spread over its tracked period
+        for(int i = 0; i < h.samples; i++){
+            rec.time[row + i] = t + i * (period * 1e-6 / h.samples);
+        }
+        t += period * 1e-6;
+        row += h.samples;
+        pos = (pos + length) & (h.capacity - 1);
+        used += length;
+    }
+    // Triggered and frozen with the ring already full, the trigger is the end
+    if(h.pre_cycles >= h.cycles){
+        rec.trigger = t;
+    }
+
+    char err[256];
+    if(comtradeSave(out_path, &rec, err, sizeof(err))){
+        fprintf(stderr, "%s\n", err);
+        return 2;
+    }
+    printf("%s: %u cycles, %u before the %s, %u of %u bytes\n", out_path, h.cycles, h.pre_cycles,
+        h.cause == RECORDER_CAUSE_TRIP ? "trip" : "pickup", h.length, h.capacity);
+    comtradeFree(&rec);
+    free(ring);
+    return 0;
+}
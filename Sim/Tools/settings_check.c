@@ -0,0 +1,184 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "main.h"
+#include "sim.h"
+
+// A setting change through settingsApply in the middle of a fault, on the whole firmware
+// and the simulated board. A balanced forward fault starts the time elements of the group
+// in use, about halfway to their trip the time dial of that group is changed and a second
+// change is offered straight after the first
+//   boundary     applying swaps nothing, the bank swaps in the cycle task together with
+//                settings_stats.applied and within a cycle of the apply
+//   refused      the second change is refused while the first waits and never lands
+//   continuity   the trip comes from the travel at the old dial up to the swap and the
+//                rest at the new one, a restart at the swap or no swap at all miss it
+// Built without the instantaneous element so the trip is the time element's. Exits with 1
+// on a failure
+
+// The firmware main, renamed by the host build
+int relay_main(void);
+
+#define FREQ_HZ 50.0
+#define SETUP_AT 0.05           // The fault setting goes into the group in use
+#define FAULT_AT 0.2
+#define CHANGE_AT 0.35          // About halfway to the trip at the fault setting
+#define END_AT 1.5
+#define LOAD_AMPS 1.0
+#define LOAD_LAG_RAD 0.5
+#define FAULT_AMPS 10.5
+#define FAULT_LAG_RAD (11.0 * M_PI / 180.0)
+#define VOLTS 63.5
+#define CT_GAIN 0.1             // Pin volts per secondary amp
+#define VT_GAIN 0.01            // Pin volts per secondary volt
+
+// The maintenance group of main.c, it picks up at 7.5 A so the fault is at PSM 1.4
+static const relayType fault_setting = {
+    .current_pickup = 0.75,
+    .time_delay = 6000.0,
+    .type = CO2,
+    .direction_angle = M_PI/3.00,
+    .residual_pickup = 0.5,
+    .instant_pickup = 0.5,
+    .instant_count = 2,
+    .harmonic_restraint = 0.15,
+};
+
+// Twice as fast, and the one that must be refused ten times as fast again
+static relayType changed_setting;
+static relayType refused_setting;
+
+static int step = 0;
+static const compiledSettings *bank_before;
+static uint32_t applied_before;
+static double offered_at;
+static double swapped_at = NAN;
+static double trip_at = NAN;
+static int failures = 0;
+
+static void check(bool ok, const char *what){
+    if(!ok){
+        printf("FAIL  %s at %.4f s\n", what, simTime());
+        failures++;
+    }
+}
+
+// The current and the voltage of each phase, balanced so the residual stays at zero
+static double pinVolts(void *ctx, uint32_t adc_channel, double t){
+    int phase;
+    bool voltage;
+    switch(adc_channel){
+    case ADC_CHANNEL_0: phase = 0; voltage = false; break;
+    case ADC_CHANNEL_1: phase = 0; voltage = true; break;
+    case ADC_CHANNEL_4: phase = 1; voltage = false; break;
+    case ADC_CHANNEL_5: phase = 1; voltage = true; break;
+    case ADC_CHANNEL_6: phase = 2; voltage = false; break;
+    case ADC_CHANNEL_7: phase = 2; voltage = true; break;
+    default: return SIM_VREF / 2.0;
+    }
+    double angle = 2.0 * M_PI * FREQ_HZ * t - phase * 2.0 * M_PI / 3.0;
+    if(voltage){
+        return SIM_VREF / 2.0 + VT_GAIN * VOLTS * M_SQRT2 * sin(angle);
+    }
+    bool fault = t >= FAULT_AT;
+    double amps = fault ? FAULT_AMPS : LOAD_AMPS;
+    double lag = fault ? FAULT_LAG_RAD : LOAD_LAG_RAD;
+    return SIM_VREF / 2.0 + CT_GAIN * amps * M_SQRT2 * sin(angle - lag);
+}
+
+// VA rises through zero at every whole cycle
+static double nextZeroCross(void *ctx, double t){
+    return (floor(t * FREQ_HZ) + 1.0) / FREQ_HZ;
+}
+
+static void outputEdge(void *ctx, const simEdge *edge){
+    if(edge->pin == GPIO_PIN_3 && edge->high){
+        trip_at = edge->time;
+        simFinish();
+    }
+}
+
+// Where the main loop would take a command, steps 0 and 2 apply, 1 and 3 wait for the swap
+static void threadIdle(void *ctx, double t){
+    const compiledSettings *bank = settingsActive();
+    switch(step){
+    case 0:
+    case 2:
+        if(t < (step ? CHANGE_AT : SETUP_AT)){
+            return;
+        }
+        bank_before = bank;
+        applied_before = settings_stats.applied;
+        offered_at = t;
+        check(settingsApply(settingsGroup(), step ? &changed_setting : &fault_setting), "change accepted");
+        if(step){
+            uint32_t refused = settings_stats.refused;
+            check(!settingsApply(settingsGroup(), &refused_setting), "second change refused");
+            check(settings_stats.refused == refused + 1, "refusal counted");
+        }
+        check(settingsActive() == bank_before, "nothing swapped by the apply");
+        step++;
+        break;
+    case 1:
+    case 3:
+        if(bank == bank_before){
+            check(t - offered_at <= 1.05 / FREQ_HZ, "swapped within a cycle");
+            return;
+        }
+        check(settings_stats.applied == applied_before + 1, "swapped by the cycle task");
+        check(t - offered_at <= 1.05 / FREQ_HZ, "swapped within a cycle");
+        if(step == 3){
+            swapped_at = t;
+        }
+        step++;
+        break;
+    default:
+        break;
+    }
+}
+
+void simFinish(void){
+    check(step == 4, "both changes swapped in");
+    check(!isnan(trip_at), "tripped");
+    check(settings_stats.applied == 2, "two changes applied");
+
+    // Travel of the element, the PSM is the same at both dials
+    double psm = FAULT_AMPS * CT_GAIN / fault_setting.current_pickup;
+    double before = getTime(&fault_setting, psm);
+    double after = getTime(&changed_setting, psm);
+    double travel = (swapped_at - FAULT_AT) / before + (trip_at - swapped_at) / after;
+    // The phasors take up to a cycle to pick up and the trip waits for a decision
+#if RELAY_DFT == RELAY_DFT_SLIDING
+    double decision = 1.0 / (FREQ_HZ * sample_times);
+#else
+    double decision = 1.0 / FREQ_HZ;
+#endif
+    double bound = (1.0 / FREQ_HZ + 2.0 * decision) / after;
+    printf("%s  swap at %.4f s, trip at %.4f s, travel %.3f of the curve, within %.3f\n",
+        fabs(travel - 1.0) <= bound ? "ok  " : "FAIL", swapped_at, trip_at, travel, bound);
+    if(!(fabs(travel - 1.0) <= bound)){
+        failures++;
+    }
+    fflush(stdout);
+    exit(failures ? 1 : 0);
+}
+
+int main(void){
+    changed_setting = fault_setting;
+    changed_setting.time_delay = 0.5 * fault_setting.time_delay;
+    refused_setting = fault_setting;
+    refused_setting.time_delay = 0.05 * fault_setting.time_delay;
+
+    static simInputs inputs = {
+        .pin_volts = pinVolts,
+        .next_zero_cross = nextZeroCross,
+        .output_edge = outputEdge,
+        .thread_idle = threadIdle,
+        .end = END_AT,
+        .overrun = -1.0,
+    };
+    simAttach(&inputs);
+    relay_main();
+    return 0;
+}
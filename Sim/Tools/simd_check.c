@@ -0,0 +1,97 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "main.h"
+#include "simd.h"
+
+// The packed fixed point DFT against its references on random Q15 data, bit for bit
+//   dualMac      the portable C of Inc/simd.h against its M4 branch on a model of
+//                SMLALD, accumulated over a cycle of random words so a mismatch in
+//                either half or in the carry into the high word shows
+//   bank         getFilteredBank against getFiltered on every channel, random scans
+//                and full scale ones at both rails
+// Built in FIXED whatever the rest of the configuration is. Exits with 1 on a mismatch
+
+#define ROUNDS 100000
+
+// The M4 dualMac, see Tools/simd_dsp.c
+int64_t dspDualMac(int64_t acc, packed16_t x, packed16_t y);
+
+// xorshift32, the same sequence on every run
+static uint32_t state = 0x12345678u;
+
+static uint32_t nextRandom(void){
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// Full scale at one of the rails now and then, they carry the largest products
+static int16_t randomSample(void){
+    uint32_t r = nextRandom();
+    switch(r & 15){
+    case 0:
+        return INT16_MIN;
+    case 1:
+        return INT16_MAX;
+    default:
+        return (int16_t)(r >> 16);
+    }
+}
+
+static packed16_t randomPacked(void){
+    return (uint16_t)randomSample() | (uint32_t)(uint16_t)randomSample() << 16;
+}
+
+static int checkDualMac(void){
+    for(long round = 0; round < ROUNDS; round++){
+        // Start anywhere a cycle of MACs cannot overflow, both signs
+        int64_t start = (int64_t)(((uint64_t)nextRandom() << 32 | nextRandom()) >> 2) - ((int64_t)1 << 61);
+        int64_t portable = start;
+        int64_t dsp = start;
+        for(int i = 0; i < sample_times; i += 2){
+            packed16_t x = randomPacked();
+            packed16_t y = randomPacked();
+            portable = dualMac(portable, x, y);
+            dsp = dspDualMac(dsp, x, y);
+            if(portable != dsp){
+                printf("dualMac round %ld pair %d: %08x x %08x gives %lld, SMLALD %lld\n",
+                    round, i / 2, (unsigned)x, (unsigned)y, (long long)portable, (long long)dsp);
+                return 1;
+            }
+        }
+    }
+    printf("dualMac: %d cycles of %d samples match SMLALD\n", ROUNDS, sample_times);
+    return 0;
+}
+
+static int checkBank(void){
+    static sample_t samples[ADC_CHANNELS][sample_times];
+    for(long round = 0; round < ROUNDS; round++){
+        for(int ch = 0; ch < ADC_CHANNELS; ch++){
+            for(int i = 0; i < sample_times; i++){
+                // The first rounds hold every channel at a rail, the worst case of the sums
+                samples[ch][i] = round == 0 ? INT16_MIN : round == 1 ? INT16_MAX : randomSample();
+            }
+        }
+        complexNum bank[ADC_CHANNELS];
+        getFilteredBank(samples, bank, COS_TABLE, SIN_TABLE);
+        for(int ch = 0; ch < ADC_CHANNELS; ch++){
+            complexNum scalar = getFiltered(samples[ch], COS_TABLE, SIN_TABLE);
+            if(scalar.real != bank[ch].real || scalar.img != bank[ch].img){
+                printf("bank round %ld channel %d: %ld%+ldj, getFiltered %ld%+ldj\n", round, ch,
+                    (long)bank[ch].real, (long)bank[ch].img, (long)scalar.real, (long)scalar.img);
+                return 1;
+            }
+        }
+    }
+    printf("bank: %d cycles of %d channels match getFiltered\n", ROUNDS, ADC_CHANNELS);
+    return 0;
+}
+
+int main(void){
+    int failed = checkDualMac();
+    failed |= checkBank();
+    return failed;
+}
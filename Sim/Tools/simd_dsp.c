@@ -0,0 +1,18 @@
+#include <stdint.h>
+
+// The M4 branch of Inc/simd.h built on the host for simd_check, with SMLALD modelled
+// from its architecture pseudocode: both signed halfword products added to the 64 bit
+// accumulator, wrapping at 64 bits
+#define __ARM_FEATURE_DSP 1
+
+static inline uint64_t __SMLALD(uint32_t op1, uint32_t op2, uint64_t acc){
+    int64_t product1 = (int64_t)(int16_t)(uint16_t)op1 * (int16_t)(uint16_t)op2;
+    int64_t product2 = (int64_t)(int16_t)(uint16_t)(op1 >> 16) * (int16_t)(uint16_t)(op2 >> 16);
+    return acc + (uint64_t)product1 + (uint64_t)product2;
+}
+
+#include "simd.h"
+
+int64_t dspDualMac(int64_t acc, packed16_t x, packed16_t y){
+    return dualMac(acc, x, y);
+}
@@ -0,0 +1,269 @@
+#define _XOPEN_SOURCE 600
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "telemetry.h"
+
+// Decode the telemetry stream of the relay into CSV, one line per frame on stdout
+// Reads a serial port, a capture file, or with --pty a pseudo terminal that the
+// replay writes to with --telemetry, so the whole path runs without a board
+//   telemetry_decode --pty > run.csv          prints the slave to give the replay
+//   OC_Relay_host --telemetry /dev/pts/N record.cfg
+// Frames with a bad CRC are skipped and the search restarts after their sync,
+// sequence gaps are frames the board dropped or the link lost, cpu_load is in
+// percent of the power cycle, trip_latency_us the worst from the last sample to the
+// trip output so far, polar is what the direction of an element stood on
+
+static const char *names_1ph[] = { "IA", "VA" };
+static const char *names_3ph[] = { "IA", "VA", "IB", "VB", "IC", "VC", "IN" };
+
+// frequencySource in the tracking byte
+static const char *tracking_names[] = { "hold", "capture", "phasor" };
+
+// polarSource in the element flags
+static const char *polar_names[] = { "measured", "memory", "held", "none" };
+
+typedef struct {
+    uint32_t frames;
+    uint32_t crc_errors;
+    uint32_t lost;
+    uint32_t skipped;       // Bytes thrown away looking for a sync
+    bool have_sequence;
+    uint16_t sequence;
+    uint8_t channels;
+    uint8_t elements;
+} decoder;
+
+static void usage(const char *argv0){
+    fprintf(stderr,
+        "usage: %s [options] PATH | --pty\n"
+        "  --pty        open a pseudo terminal and print the slave to give the replay\n"
+        "  --baud N     serial port speed (default %d)\n"
+        "  --idle S     exit S seconds after the last frame, 0 waits forever (default 2)\n",
+        argv0, TELEMETRY_BAUD);
+    exit(2);
+}
+
+static speed_t baudConstant(long baud){
+    switch(baud){
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    case 921600: return B921600;
+    default: return B0;
+    }
+}
+
+// Raw 8N1, nothing translated, harmless on a plain file
+static void makeRaw(int fd, long baud){
+    struct termios tio;
+    if(tcgetattr(fd, &tio)){
+        return;
+    }
+    cfmakeraw(&tio);
+    speed_t speed = baudConstant(baud);
+    if(speed != B0){
+        cfsetispeed(&tio, speed);
+        cfsetospeed(&tio, speed);
+    }
+    tcsetattr(fd, TCSANOW, &tio);
+}
+
+static float getFloat(const uint8_t *p){
+    float value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static void csvHeader(decoder *d, uint8_t channels, uint8_t elements){
+    d->channels = channels;
+    d->elements = elements;
+    printf("sequence,period_us,frequency_hz,tracking,cpu_load,trip_latency_us,group,tripped,forward,instant,restrained");
+    for(int ch = 0; ch < channels; ch++){
+        const char *name = channels == 2 ? names_1ph[ch] : channels <= 7 ? names_3ph[ch] : NULL;
+        if(name){
+            printf(",%s_mag,%s_deg", name, name);
+        } else {
+            printf(",CH%d_mag,CH%d_deg", ch + 1, ch + 1);
+        }
+    }
+    for(int e = 0; e < elements; e++){
+        printf(",E%d_psm,E%d_progress,E%d_pickup,E%d_forward,E%d_polar", e + 1, e + 1, e + 1, e + 1, e + 1);
+    }
+    printf("\n");
+}
+
+// One frame with a good CRC
+static void emitFrame(decoder *d, const uint8_t *frame, uint8_t length){
+    const uint8_t *p = frame + TELEMETRY_HEADER;
+    uint16_t sequence = frame[4] | frame[5] << 8;
+    uint32_t period;
+    memcpy(&period, p, sizeof(period));
+    uint8_t channels = p[4];
+    uint8_t elements = p[5];
+    uint8_t state = p[6];
+    uint8_t tracking = p[7];
+    uint16_t load = p[8] | p[9] << 8;
+    uint16_t trip_latency = p[10] | p[11] << 8;
+    if(length != 12 + channels * 8 + elements * 9){
+        d->crc_errors++;
+        return;
+    }
+    if(!d->frames || channels != d->channels || elements != d->elements){
+        csvHeader(d, channels, elements);
+    }
+    if(d->have_sequence && sequence != (uint16_t)(d->sequence + 1)){
+        d->lost += (uint16_t)(sequence - d->sequence - 1);
+    }
+    d->have_sequence = true;
+    d->sequence = sequence;
+    d->frames++;
+
+    printf("%u,%u,%.4f,%s,%.1f,%u,%d,%d,%d,%d,%d", sequence, period, period ? 1e6 / period : 0.0,
+        tracking < 3 ? tracking_names[tracking] : "?", load / 10.0, trip_latency, (state & TELEMETRY_GROUP) >> TELEMETRY_GROUP_SHIFT, !!(state & TELEMETRY_TRIPPED), !!(state & TELEMETRY_FORWARD), !!(state & TELEMETRY_INSTANT),
+        !!(state & TELEMETRY_RESTRAINED));
+    p += 12;
+    for(int ch = 0; ch < channels; ch++, p += 8){
+        double re = getFloat(p);
+        double im = getFloat(p + 4);
+        // The RMS of the fundamental in volts at the pin, the phasor is its peak
+        printf(",%.6f,%.3f", hypot(re, im) / sqrt(2.0), atan2(im, re) * 180.0 / M_PI);
+    }
+    const uint8_t *flags = p + elements * 8;
+    for(int e = 0; e < elements; e++, p += 8){
+        double psm2 = getFloat(p);
+        printf(",%.4f,%.6f,%d,%d,%s", sqrt(psm2 > 0.0 ? psm2 : 0.0), getFloat(p + 4),
+            !!(flags[e] & TELEMETRY_PICKUP), !!(flags[e] & TELEMETRY_FORWARD),
+            polar_names[(flags[e] & TELEMETRY_POLAR) >> TELEMETRY_POLAR_SHIFT]);
+    }
+    printf("\n");
+}
+
+// Take every whole frame out of buf, returns the bytes left for the next read
+static size_t scan(decoder *d, uint8_t *buf, size_t n){
+    size_t i = 0;
+    while(n - i >= TELEMETRY_HEADER){
+        if(buf[i] != TELEMETRY_SYNC0 || buf[i + 1] != TELEMETRY_SYNC1 || buf[i + 2] != TELEMETRY_VERSION){
+            i++;
+            d->skipped++;
+            continue;
+        }
+        uint8_t length = buf[i + 3];
+        size_t frame = TELEMETRY_HEADER + length + TELEMETRY_TRAILER;
+        if(n - i < frame){
+            break;
+        }
+        uint16_t crc = buf[i + frame - 2] | buf[i + frame - 1] << 8;
+        if(telemetryCrc(buf + i + 2, TELEMETRY_HEADER - 2 + length) != crc){
+            // A sync pattern inside a frame or a damaged frame, look again one byte on
+            d->crc_errors++;
+            i++;
+            continue;
+        }
+        emitFrame(d, buf + i, length);
+        i += frame;
+    }
+    fflush(stdout);
+    memmove(buf, buf + i, n - i);
+    return n - i;
+}
+
+int main(int argc, char **argv){
+    const char *path = NULL;
+    bool pty = false;
+    long baud = TELEMETRY_BAUD;
+    double idle = 2.0;
+
+    for(int i = 1; i < argc; i++){
+        const char *a = argv[i];
+        bool more = i + 1 < argc;
+        if(!strcmp(a, "--pty")){
+            pty = true;
+        } else if(!strcmp(a, "--baud") && more){
+            baud = atol(argv[++i]);
+        } else if(!strcmp(a, "--idle") && more){
+            idle = atof(argv[++i]);
+        } else if(a[0] == '-' || path){
+            usage(argv[0]);
+        } else {
+            path = a;
+        }
+    }
+    if(pty == !!path){
+        usage(argv[0]);
+    }
+
+    int fd;
+    int slave = -1;
+    if(pty){
+        fd = posix_openpt(O_RDWR | O_NOCTTY);
+        if(fd < 0 || grantpt(fd) || unlockpt(fd)){
+            fprintf(stderr, "cannot open a pseudo terminal\n");
+            return 2;
+        }
+        // Hold the slave open in raw mode, the writer coming and going then never
+        // resets it and the master never reads end of file
+        const char *name = ptsname(fd);
+        slave = open(name, O_RDWR | O_NOCTTY);
+        if(slave < 0){
+            fprintf(stderr, "cannot open %s\n", name);
+            return 2;
+        }
+        makeRaw(slave, baud);
+        fprintf(stderr, "%s\n", name);
+    } else {
+        fd = open(path, O_RDONLY | O_NOCTTY);
+        if(fd < 0){
+            fprintf(stderr, "cannot open %s\n", path);
+            return 2;
+        }
+        makeRaw(fd, baud);
+    }
+
+    decoder d = {0};
+    static uint8_t buf[4096];
+    size_t have = 0;
+    while(1){
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+        int timeout = d.frames && idle > 0.0 ? (int)(idle * 1000.0) : -1;
+        int ready = poll(&pfd, 1, timeout);
+        if(ready == 0){
+            break;
+        }
+        if(ready < 0){
+            perror("poll");
+            break;
+        }
+        ssize_t n = read(fd, buf + have, sizeof(buf) - have);
+        if(n <= 0){
+            break;
+        }
+        have = scan(&d, buf, have + (size_t)n);
+        // Nothing that long is a frame, drop the oldest half
+        if(have == sizeof(buf)){
+            d.skipped += sizeof(buf) / 2;
+            memmove(buf, buf + sizeof(buf) / 2, sizeof(buf) / 2);
+            have = sizeof(buf) / 2;
+        }
+    }
+
+    fprintf(stderr, "%u frames, %u lost, %u bad CRC, %u bytes skipped\n", d.frames, d.lost, d.crc_errors, d.skipped);
+    if(slave >= 0){
+        close(slave);
+    }
+    close(fd);
+    return d.crc_errors || d.lost ? 1 : 0;
+}
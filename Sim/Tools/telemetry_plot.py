@@ -0,0 +1,49 @@
+#!/usr/bin/env python3
+# Plot the CSV of telemetry_decode, from a file or stdin
+#   telemetry_decode --pty | python3 telemetry_plot.py
+# Magnitudes of every channel, the PSM and the trip progress of every element
+# against the frame time, the time axis adds up the tracked periods
+import csv
+import sys
+
+import matplotlib.pyplot as plt
+
+
+def main():
+    source = open(sys.argv[1]) if len(sys.argv) > 1 else sys.stdin
+    rows = list(csv.DictReader(source))
+    if not rows:
+        sys.exit("no frames")
+
+    t = []
+    now = 0.0
+    for r in rows:
+        t.append(now)
+        now += float(r["period_us"]) * 1e-6
+
+    columns = rows[0].keys()
+    channels = [c[:-4] for c in columns if c.endswith("_mag")]
+    elements = [c[:-4] for c in columns if c.endswith("_psm")]
+
+    fig, (mag, psm, prog) = plt.subplots(3, 1, sharex=True)
+    for ch in channels:
+        mag.plot(t, [float(r[ch + "_mag"]) for r in rows], label=ch)
+    mag.set_ylabel("RMS at the pin (V)")
+    mag.legend(loc="upper left")
+
+    for e in elements:
+        psm.plot(t, [float(r[e + "_psm"]) for r in rows], label=e)
+        prog.plot(t, [float(r[e + "_progress"]) for r in rows], label=e)
+    psm.axhline(1.0, color="grey", linewidth=0.5)
+    psm.set_ylabel("PSM")
+    psm.legend(loc="upper left")
+    prog.step(t, [int(r["tripped"]) for r in rows], where="post", color="red", label="tripped")
+    prog.set_ylabel("progress")
+    prog.set_xlabel("time (s)")
+    prog.legend(loc="upper left")
+
+    plt.show()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,638 @@
+#include "main.h"
+
+// The cycle handed to the main loop, one row per channel, unpacked from the raw codes
+static sample_t adc_data_A[ADC_CHANNELS][sample_times];
+
+#if RELAY_ACQ == RELAY_ACQ_DMA
+
+// Raw scans written by the DMA, one power cycle per half of the circular buffer
+// Oversampled the decimator writes them, one from every burst
+static uint16_t adc_dma_buffer[2][sample_times * ADC_CHANNELS];
+
+#if RELAY_OVERSAMPLE > 1
+// The conversions of one sample per half, the DMA wraps around these instead
+static uint16_t adc_burst[2][RELAY_OVERSAMPLE * ADC_CHANNELS];
+
+// Scans the decimator wrote, counted from the start of the buffer
+static volatile uint32_t scan_written = 0;
+#endif
+
+// Half and full transfer events, each one is a complete cycle
+volatile uint32_t cycles_done = 0;
+
+// The last cycle handed to the main loop
+static uint32_t cycles_taken = 0;
+
+// A scan by the cycle it belongs to, as cycles_done counts them, and its place in that
+// cycle. Free running, so a reader a whole buffer behind is told apart from one in step
+typedef struct {
+    uint32_t cycle;
+    uint32_t index;
+} scanPosition;
+
+// A reader of the scans, the DFT and the instantaneous element each have their own
+typedef struct {
+    // The next scan it takes
+    scanPosition at;
+    // The restarts it has caught up with
+    uint32_t restarts;
+    // Scans were lost before the next one
+    bool lost;
+    // Of those, the scans the DMA wrote over before the reader got to them
+    uint32_t lapped;
+} scanReader;
+
+// Restarts of the transfer after an overrun, a reader that has seen fewer lost its place
+static volatile uint32_t restarts = 0;
+
+// Where the scans stopped at the last restart and the cycle the restarted transfer writes
+static volatile scanPosition restart_stop;
+static volatile uint32_t restart_cycle = 0;
+
+#else
+
+// Ping pong buffers of raw codes, interleaved like the DMA would write them. The
+// interrupt only stores integers, the main loop unpacks the finished cycle
+static uint16_t raw_cycles[2][sample_times * ADC_CHANNELS];
+
+// Semaphore for the main loop
+volatile bool Sign = false;
+
+// The buffer of the last complete cycle, the interrupt fills the other one
+volatile uint8_t active_buffer = 0;
+
+#endif
+
+// Cycles the main loop was too slow to pick up
+volatile uint32_t missed_cycles = 0;
+
+// Scans a reader lost to an overrun restart or to the DMA lapping it, summed over the readers
+volatile uint32_t dropped_scans = 0;
+
+// To dynamically set the time period for the phase locked loop
+volatile uint32_t g_current_period = 20000.00; // The 1MHz ticks for one cycle
+
+// Analog inputs in rank order, PA2 and PA3 stay free for the UART and the trip output
+// and PB10 is the zero crossing capture
+static const struct {
+    GPIO_TypeDef *port;
+    uint16_t pin;
+    uint32_t channel;
+} adc_inputs[ADC_CHANNELS] = {
+    [CH_IA] = { GPIOA, GPIO_PIN_0, ADC_CHANNEL_0 },
+    [CH_VA] = { GPIOA, GPIO_PIN_1, ADC_CHANNEL_1 },
+#if RELAY_PHASES == 3
+    [CH_IB] = { GPIOA, GPIO_PIN_4, ADC_CHANNEL_4 },
+    [CH_VB] = { GPIOA, GPIO_PIN_5, ADC_CHANNEL_5 },
+    [CH_IC] = { GPIOA, GPIO_PIN_6, ADC_CHANNEL_6 },
+    [CH_VC] = { GPIOA, GPIO_PIN_7, ADC_CHANNEL_7 },
+#if RELAY_RESIDUAL == RELAY_RESIDUAL_MEASURED
+    [CH_IN] = { GPIOB, GPIO_PIN_0, ADC_CHANNEL_8 },
+#endif
+#endif
+};
+
+// Hardware Handles
+TIM_HandleTypeDef adc_trigger;
+ADC_HandleTypeDef adc_handle;
+TIM_HandleTypeDef zero_handle;
+DMA_HandleTypeDef adc_dma_handle;
+
+#if RELAY_ACQ == RELAY_ACQ_DMA
+// Whole scans in the buffer, counted from its start
+static inline uint32_t scansInBuffer(void){
+#if RELAY_OVERSAMPLE > 1
+    return scan_written;
+#else
+    // In circular mode the counter reloads instead of reaching 0, so this stays below 2N
+    // Only whole scans, the voltage may still be converting
+    return (2 * sample_times * ADC_CHANNELS - __HAL_DMA_GET_COUNTER(&adc_dma_handle)) / ADC_CHANNELS;
+#endif
+}
+
+// Where the next scan is written. The count is read first, so a half that is full but
+// not yet counted shows as the buffer being a half ahead of it and is counted here
+static scanPosition scansWritten(void){
+    uint32_t done = cycles_done;
+    uint32_t offset = (scansInBuffer() + (2 - (done & 1)) * sample_times) % (2 * sample_times);
+    if(offset >= sample_times){
+        return (scanPosition){ done + 1, offset - sample_times };
+    }
+    return (scanPosition){ done, offset };
+}
+
+// Scans from one position up to another, the count wraps with the cycles
+static inline uint32_t scansBetween(scanPosition from, scanPosition to){
+    return (to.cycle - from.cycle) * sample_times + to.index - from.index;
+}
+#endif
+
+#if RELAY_OVERSAMPLE > 1
+
+// The conversions are 12 bit here and a scan of them has to be done before the next
+// trigger at the highest frequency tracked, the ADC clock is PCLK2 over 2
+#define SAMPLING_CYCLES 28
+#if (SAMPLING_CYCLES + 12) * ADC_CHANNELS * TRIGGERS_PER_CYCLE * FREQUENCY_MAX_HZ > 42000000
+#error "The oversampled scans do not fit between the triggers, lower RELAY_OVERSAMPLE or RELAY_SAMPLES"
+#endif
+
+// A burst is in, decimate it into the next scan. Work only on samples, so this wakes the
+// core once a sample like the end of sequence does without oversampling
+static void burstDone(const uint16_t *burst){
+    latencyMark(LAT_ADC_ISR);
+    uint32_t at = scan_written;
+    decimatorBurst(burst, &adc_dma_buffer[0][at * ADC_CHANNELS]);
+    at++;
+    bool cycle = at % sample_times == 0;
+    if(cycle){
+        cycles_done++;
+        recorderCycle(adc_dma_buffer[at / sample_times - 1], g_current_period);
+    }
+    scan_written = at == 2 * sample_times ? 0 : at;
+    // The cycle DFT alone only needs the whole cycles
+    if(RELAY_DFT == RELAY_DFT_SLIDING || RELAY_INSTANT || cycle){
+        schedulerPost(TASK_ACQUISITION);
+    }
+}
+
+void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef *hadc){
+    burstDone(adc_burst[0]);
+}
+
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc){
+    burstDone(adc_burst[1]);
+}
+
+// An overrun stops the DMA requests, the decimated scans keep their place and only the
+// bursts start over, the lost conversions are a glitch through the filter
+void HAL_ADC_ErrorCallback(ADC_HandleTypeDef *hadc){
+    HAL_ADC_Stop_DMA(hadc);
+    missed_cycles++;
+    HAL_ADC_Start_DMA(hadc, (uint32_t *)adc_burst, 2 * RELAY_OVERSAMPLE * ADC_CHANNELS);
+}
+
+#elif RELAY_ACQ == RELAY_ACQ_DMA
+
+// The DMA filled the first half of the circular buffer
+void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef *hadc){
+    latencyMark(LAT_ADC_ISR);
+    cycles_done++;
+    recorderCycle(adc_dma_buffer[0], g_current_period);
+    schedulerPost(TASK_ACQUISITION);
+}
+
+// The DMA filled the second half and wrapped around
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc){
+    latencyMark(LAT_ADC_ISR);
+    cycles_done++;
+    recorderCycle(adc_dma_buffer[1], g_current_period);
+    schedulerPost(TASK_ACQUISITION);
+}
+
+// An overrun stops the DMA requests, restart the circular transfer from the first half
+// The readers catch up at their next poll, the restart only tells them where it stopped
+void HAL_ADC_ErrorCallback(ADC_HandleTypeDef *hadc){
+    scanPosition stop = scansWritten();
+    restart_stop.cycle = stop.cycle;
+    restart_stop.index = stop.index;
+    HAL_ADC_Stop_DMA(hadc);
+    // Keep the count even so the next half transfer still maps to the first half
+    if(cycles_done & 1){
+        cycles_done++;
+    }
+    restart_cycle = cycles_done;
+    missed_cycles++;
+    restarts++;
+    HAL_ADC_Start_DMA(hadc, (uint32_t *)adc_dma_buffer, 2 * sample_times * ADC_CHANNELS);
+}
+
+#else
+
+// Interrupt callback for ADC the interrupt must call this internally i guess
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc){
+    // The conversions arrive in rank order, see adc_inputs
+    static int interrupt_count = 0;
+    static uint8_t which = 0;
+
+    latencyMark(LAT_ADC_ISR);
+    uint16_t *raw = raw_cycles[!active_buffer];
+    raw[interrupt_count * ADC_CHANNELS + which] = (uint16_t)HAL_ADC_GetValue(hadc);
+
+    which++;
+    if(which == ADC_CHANNELS){
+#if RELAY_INSTANT
+        // A whole scan is in, the instantaneous element does not wait for the cycle
+        instantScan(&raw[interrupt_count * ADC_CHANNELS]);
+#endif
+        which = 0;
+        interrupt_count++;
+    }
+
+    // wait for a whole cycle of scans
+    if(interrupt_count == sample_times) {
+        interrupt_count = 0;
+        recorderCycle(raw, g_current_period);
+        if(Sign){
+            missed_cycles++;
+        }
+        active_buffer = !active_buffer; // <-- SWAP THE ACTIVE BUFFER
+        // result is ready signal the main
+        Sign = true;
+        schedulerPost(TASK_ACQUISITION);
+    }
+}
+
+#endif
+
+// Interrupt call back for the capture timer
+void HAL_TIM_IC_CaptureCallback(TIM_HandleTypeDef *htim) {
+    // Make sure the interrupt came from TIM2
+    if (htim->Instance == TIM2) {
+        // Only timestamped here, the trigger timer is retuned once a cycle from the main loop
+        frequencyCapture(HAL_TIM_ReadCapturedValue(htim, TIM_CHANNEL_3));
+    }
+}
+
+// Raw codes of a cycle into the samples of the main loop, one row per channel
+static void unpackCycle(const uint16_t *raw){
+    for(int i = 0; i < sample_times; i++){
+        for(int ch = 0; ch < ADC_CHANNELS; ch++){
+            adc_data_A[ch][i] = toSample(raw[i * ADC_CHANNELS + ch]);
+        }
+    }
+}
+
+// Hand the last complete cycle to the main loop, false if nothing new arrived
+bool takeCycle(cycleSamples *cycle){
+#if RELAY_ACQ == RELAY_ACQ_DMA
+    // Single word reads, the ISR only ever increments them so no critical section
+    static uint32_t cycle_restarts = 0;
+    uint32_t restart = restarts;
+    uint32_t done = cycles_done;
+    // An overrun restart starts the halves over, the cycle under way when it hit is not
+    // whole. Take the next one that is
+    if(restart != cycle_restarts){
+        if(restarts == restart){
+            cycle_restarts = restart;
+            cycles_taken = done;
+        }
+        return false;
+    }
+    if(done == cycles_taken){
+        return false;
+    }
+    if(done - cycles_taken > 1){
+        missed_cycles += done - cycles_taken - 1;
+    }
+    cycles_taken = done;
+
+    // The DMA is busy with the other half for a whole cycle, convert this one
+    unpackCycle(adc_dma_buffer[(done - 1) & 1]);
+    cycle->samples = adc_data_A;
+    return true;
+#else
+    // Is the semaphore set
+    if(Sign == false){
+        return false;
+    }
+
+    uint8_t buffer_to_process;
+
+    // Disable the ADC interrupt to prevent 'active_buffer'
+    // and 'Sign' from being changed while we read them.
+    HAL_NVIC_DisableIRQ(ADC_IRQn);
+
+    // Latch the buffer that is ready for processing
+    buffer_to_process = active_buffer; 
+    // Clear the flag *inside* the critical section
+    Sign = false; 
+
+    // Re-enable the interrupt
+    HAL_NVIC_EnableIRQ(ADC_IRQn);
+
+    // The interrupt is busy with the other buffer for a whole cycle, convert this one
+    unpackCycle(raw_cycles[buffer_to_process]);
+    cycle->samples = adc_data_A;
+    return true;
+#endif
+}
+
+#if RELAY_ACQ == RELAY_ACQ_DMA
+static inline const uint16_t *scanAt(scanPosition at){
+    return &adc_dma_buffer[at.cycle & 1][at.index * ADC_CHANNELS];
+}
+
+static inline void scanNext(scanPosition *at){
+    at->index++;
+    if(at->index == sample_times){
+        at->index = 0;
+        at->cycle++;
+    }
+}
+
+// Catch a reader up with an overrun restart or with the DMA that went round the whole
+// buffer past it, and return where the writer is. Either way it goes on from the start
+// of a cycle, so the sliding windows can start over in step with the twiddles
+static scanPosition scanCatchUp(scanReader *reader){
+    uint32_t restart = restarts;
+    scanPosition stop = { restart_stop.cycle, restart_stop.index };
+    uint32_t resume = restart_cycle;
+    scanPosition written = scansWritten();
+    // Restarted under us, the position may be of either transfer
+    if(restarts != restart){
+        return reader->at;
+    }
+    if(restart != reader->restarts){
+        // The scans it had not taken up to the stop are gone, never the old ones out of order
+        int32_t unread = (int32_t)scansBetween(reader->at, stop);
+        if(unread > 0){
+            dropped_scans += unread;
+        }
+        reader->at = (scanPosition){ resume, 0 };
+        reader->restarts = restart;
+        reader->lost = true;
+    }
+    // A whole buffer behind the oldest scans it had not taken are written over already
+    if(scansBetween(reader->at, written) >= 2 * sample_times){
+        scanPosition start = { written.cycle, 0 };
+        uint32_t skipped = scansBetween(reader->at, start);
+        dropped_scans += skipped;
+        reader->lapped += skipped;
+        reader->at = start;
+        reader->lost = true;
+    }
+    return written;
+}
+
+static scanReader scan_reader;
+
+// Hand the next complete scan to the main loop, false if the DMA has not written one yet
+// The write position comes from the DMA counter so this costs no interrupts at all,
+// oversampled from the decimator that runs once a sample anyway
+bool takeScan(scanSample *scan){
+    scanPosition written = scanCatchUp(&scan_reader);
+    if(scansBetween(scan_reader.at, written) == 0){
+        return false;
+    }
+    // The main loop was too slow for whole cycles, like takeCycle counts them
+    if(scan_reader.lapped){
+        missed_cycles += (scan_reader.lapped + sample_times - 1) / sample_times;
+        scan_reader.lapped = 0;
+    }
+
+    const uint16_t *raw = scanAt(scan_reader.at);
+    for(int ch = 0; ch < ADC_CHANNELS; ch++){
+        scan->value[ch] = toSample(raw[ch]);
+    }
+    scan->resync = scan_reader.lost;
+    scan_reader.lost = false;
+    scanNext(&scan_reader.at);
+    return true;
+}
+#endif
+
+#if RELAY_INSTANT && RELAY_ACQ == RELAY_ACQ_DMA
+// The scans the instantaneous element has seen, on its own reader so the cycle DFT needs no scans
+static scanReader instant_reader;
+
+void instantPoll(void){
+    scanPosition written = scanCatchUp(&instant_reader);
+    // The laps are counted as missed cycles by the DFT's reader or by takeCycle
+    instant_reader.lapped = 0;
+    if(instant_reader.lost){
+        instant_reader.lost = false;
+        instantGap();
+    }
+    while(scansBetween(instant_reader.at, written) != 0){
+        instantScan(scanAt(instant_reader.at));
+        scanNext(&instant_reader.at);
+    }
+}
+#endif
+
+// Start the zero crossing capture, the trigger timer and the conversions
+void acquisition_start(void){
+    HAL_TIM_IC_Start_IT(&zero_handle, TIM_CHANNEL_3);
+    HAL_TIM_Base_Start(&adc_trigger);
+#if RELAY_OVERSAMPLE > 1
+    // Two bursts in the circular buffer, every half transfer is a sample
+    HAL_ADC_Start_DMA(&adc_handle, (uint32_t *)adc_burst, 2 * RELAY_OVERSAMPLE * ADC_CHANNELS);
+#elif RELAY_ACQ == RELAY_ACQ_DMA
+    HAL_ADC_Start_DMA(&adc_handle, (uint32_t *)adc_dma_buffer, 2 * sample_times * ADC_CHANNELS);
+#if RELAY_DFT == RELAY_DFT_SLIDING || RELAY_INSTANT
+    // Work on every scan, the end of the sequence wakes the core for it
+    __HAL_ADC_ENABLE_IT(&adc_handle, ADC_IT_EOC);
+#endif
+#else
+    HAL_ADC_Start_IT(&adc_handle);
+#endif
+}
+
+// Initialize the trigger time of the PLL
+void timer_init(void) {
+    __HAL_RCC_TIM3_CLK_ENABLE();
+    // Use Timer 3, the 32 bit TIM2 is the zero crossing capture
+    adc_trigger.Instance = TIM3;
+    // for 1 Mhz, or 21MHz oversampled
+    adc_trigger.Init.Prescaler = 84 / TRIGGER_TICKS_PER_US - 1;
+    // Count up
+    adc_trigger.Init.CounterMode = TIM_COUNTERMODE_UP;
+    // Let the period be 0 we will update once zero crosser is ready
+    adc_trigger.Init.Period = SAMPLE_RELOAD(g_current_period);
+    // no div
+    adc_trigger.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+    // A new period takes effect at the next update, written straight away it can
+    // land below the count and the counter would run the whole way round
+    adc_trigger.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_ENABLE;
+    // high priority will adjust later
+    HAL_TIM_Base_Init(&adc_trigger);
+
+    TIM_MasterConfigTypeDef sMasterConfig = {0};
+    sMasterConfig.MasterOutputTrigger = TIM_TRGO_UPDATE;
+    sMasterConfig.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+    HAL_TIMEx_MasterConfigSynchronization(&adc_trigger, &sMasterConfig);
+
+}
+
+// setup a phase locked loops to trigger the adc based on incoming exti interrupts
+void pll_init(void){
+    __HAL_RCC_TIM2_CLK_ENABLE();
+    __HAL_RCC_GPIOB_CLK_ENABLE(); // already enabled for ADC
+    GPIO_InitTypeDef GPIO_InitStruct = {
+        // Pin 10, TIM2 channel 3
+        .Pin = GPIO_PIN_10, 
+        // Set as analog mode
+        .Mode = GPIO_MODE_AF_PP, 
+        // No push pull
+        .Pull = GPIO_NOPULL,
+        // High freq for the zero cross detector
+        .Speed = GPIO_SPEED_FREQ_HIGH,
+        // connect to the tim2
+        .Alternate = GPIO_AF1_TIM2,
+    };
+
+    HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
+
+    zero_handle.Instance = TIM2;
+    // The full 84MHz, 12ns a tick
+    zero_handle.Init.Prescaler = 0;
+    // count up
+    zero_handle.Init.CounterMode = TIM_COUNTERMODE_UP;
+    // Free running over all 32 bits, wraps every 51 seconds
+    zero_handle.Init.Period = 0xFFFFFFFF;
+    // Also irrelevant
+    zero_handle.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+    // Irrelevant
+    // .RepetitionCounter =  
+    zero_handle.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+    HAL_TIM_Base_Init(&zero_handle);
+
+    TIM_IC_InitTypeDef sConfigIC = {0};
+
+    // Trigger on the rising edge
+    sConfigIC.ICPolarity = TIM_INPUTCHANNELPOLARITY_RISING;
+
+    // Connect the pin TI1 to the timer's capture register
+    sConfigIC.ICSelection = TIM_ICSELECTION_DIRECTTI; 
+
+    // Don't skip any events
+    sConfigIC.ICPrescaler = TIM_ICPSC_DIV1; 
+
+    // No filter (for a clean ZC signal)
+    sConfigIC.ICFilter = 0; 
+    HAL_TIM_IC_ConfigChannel(&zero_handle, &sConfigIC, TIM_CHANNEL_3);
+
+    HAL_NVIC_SetPriority(TIM2_IRQn, 0, 0); // High priority
+    HAL_NVIC_EnableIRQ(TIM2_IRQn);
+
+}
+
+#if RELAY_ACQ == RELAY_ACQ_DMA
+// ADC1 is wired to DMA2 stream 0 channel 0
+static void adc_dma_init(void){
+    __HAL_RCC_DMA2_CLK_ENABLE();
+
+    adc_dma_handle.Instance = DMA2_Stream0;
+    adc_dma_handle.Init.Channel = DMA_CHANNEL_0;
+    adc_dma_handle.Init.Direction = DMA_PERIPH_TO_MEMORY;
+    // Always read the same data register
+    adc_dma_handle.Init.PeriphInc = DMA_PINC_DISABLE;
+    adc_dma_handle.Init.MemInc = DMA_MINC_ENABLE;
+    // The raw 10 or 12 bit results as half words
+    adc_dma_handle.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+    adc_dma_handle.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+    // Wrap around forever, half and full transfer split the two cycles
+    adc_dma_handle.Init.Mode = DMA_CIRCULAR;
+    adc_dma_handle.Init.Priority = DMA_PRIORITY_HIGH;
+    adc_dma_handle.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+    HAL_DMA_Init(&adc_dma_handle);
+
+    __HAL_LINKDMA(&adc_handle, DMA_Handle, adc_dma_handle);
+
+    HAL_NVIC_SetPriority(DMA2_Stream0_IRQn, 1, 0);
+    HAL_NVIC_EnableIRQ(DMA2_Stream0_IRQn);
+}
+#endif
+
+// Setup the adc and return the handle
+void adc_init(void){
+
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+    __HAL_RCC_GPIOB_CLK_ENABLE();
+
+    // Initialize every input as an analog pin
+    for(int ch = 0; ch < ADC_CHANNELS; ch++){
+        GPIO_InitTypeDef GPIO_InitStruct = {
+            .Pin = adc_inputs[ch].pin,
+            // Set as analog mode
+            .Mode = GPIO_MODE_ANALOG, 
+            // No push pull
+            .Pull = GPIO_NOPULL, 
+            // LOW doesnt matter anyways
+            .Speed = GPIO_SPEED_FREQ_LOW,
+        };
+
+        HAL_GPIO_Init(adc_inputs[ch].port, &GPIO_InitStruct);
+    }
+
+    // Initialize the ADC instance
+    adc_handle.Instance = ADC1;
+    // Peripheral clock scaled down by 2
+    adc_handle.Init.ClockPrescaler = ADC_CLOCK_SYNC_PCLK_DIV2;
+#if RELAY_OVERSAMPLE > 1
+    // The full 12 bit, the decimation adds to that
+    adc_handle.Init.Resolution = ADC_RESOLUTION_12B;
+#else
+    // 10 Bit like in the paper
+    adc_handle.Init.Resolution = ADC_RESOLUTION_10B;
+#endif
+    // Big Endian easier DFT
+    adc_handle.Init.DataAlign = ADC_DATAALIGN_RIGHT;
+    // We need to convert multiple channels simultaneously for CT and PT
+    adc_handle.Init.ScanConvMode = ENABLE;
+#if RELAY_ACQ == RELAY_ACQ_DMA
+    // The DMA moves every conversion, EOC only at the end of the sequence
+    adc_handle.Init.EOCSelection = ADC_EOC_SEQ_CONV;
+#else
+    // Interrupt for each conversion first for the current and then for the voltage
+    adc_handle.Init.EOCSelection = ADC_EOC_SINGLE_CONV;
+#endif
+    // ADC samples all channels and stops and waits for the external trigger to start the sequence again
+    adc_handle.Init.ContinuousConvMode = DISABLE;
+    // Every current and voltage in one sequence
+    adc_handle.Init.NbrOfConversion = ADC_CHANNELS;
+    // Convert the entire seq in one go
+    adc_handle.Init.DiscontinuousConvMode = DISABLE;
+    // Externally triggered by an exti interrupt whenver zero crossing occurs 
+    adc_handle.Init.ExternalTrigConv = ADC_EXTERNALTRIGCONV_T3_TRGO; 
+    // Trigger at timer rising edge,
+    adc_handle.Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_RISING;
+#if RELAY_ACQ == RELAY_ACQ_DMA
+    // Keep requesting the DMA after every sequence, the circular buffer never ends
+    adc_handle.Init.DMAContinuousRequests = ENABLE;
+#else
+    //Do not Re Arm the ADC by itself and continue, till CPU intervention
+    adc_handle.Init.DMAContinuousRequests = DISABLE;
+#endif
+
+    __HAL_RCC_ADC1_CLK_ENABLE();
+
+
+    HAL_ADC_Init(&adc_handle);
+
+    for(int ch = 0; ch < ADC_CHANNELS; ch++){
+        ADC_ChannelConfTypeDef ADC_Channel_InitStruct = {
+            // Specify the ADC channel
+            .Channel = adc_inputs[ch].channel,
+            // The rank of data to sample
+            .Rank = ch + 1,
+            // Not sure about this one I think its samples every 84 cycles
+            // Clock div is 2 so for 16MHz hsi thats like 8Mhz for the adc basically every 10.5 uS
+            // Even seven of them fit easily inside one sample period
+#if RELAY_OVERSAMPLE > 1
+            // Oversampled the scans come many times faster, the shorter sampling wants a stiffer source
+            .SamplingTime = ADC_SAMPLETIME_28CYCLES,
+#else
+            .SamplingTime = ADC_SAMPLETIME_84CYCLES,
+#endif
+            // Future use set to 0
+            .Offset = 0,
+        };
+
+        HAL_ADC_ConfigChannel(&adc_handle, &ADC_Channel_InitStruct);
+    }
+
+
+#if RELAY_ACQ == RELAY_ACQ_DMA
+    adc_dma_init();
+    // Overruns and the end of a scan, the conversions themselves are moved by the DMA
+    HAL_NVIC_SetPriority(ADC_IRQn, 1, 0);
+    HAL_NVIC_EnableIRQ(ADC_IRQn);
+#else
+    __HAL_ADC_ENABLE(&adc_handle);
+    __HAL_ADC_ENABLE_IT(&adc_handle, ADC_IT_EOC);
+    HAL_NVIC_SetPriority(ADC_IRQn, 1, 0);
+    HAL_NVIC_EnableIRQ(ADC_IRQn);
+#endif
+
+}
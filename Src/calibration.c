@@ -0,0 +1,39 @@
+#include "main.h"
+
+#if RELAY_CALIBRATION
+
+// Nominal until the board is measured, a channel reading 2% low and 0.5 degrees late
+// takes { 1.0204f, 0.5f, ... }. The bias is the divider's mid rail
+#define NOMINAL { 1.0f, 0.0f, (float)(ADC_VREF / 2.0) }
+
+const channelCalibration channel_calibration[ADC_CHANNELS] = {
+    [CH_IA] = NOMINAL,
+    [CH_VA] = NOMINAL,
+#if RELAY_PHASES == 3
+    [CH_IB] = NOMINAL,
+    [CH_VB] = NOMINAL,
+    [CH_IC] = NOMINAL,
+    [CH_VC] = NOMINAL,
+#if RELAY_RESIDUAL == RELAY_RESIDUAL_MEASURED
+    [CH_IN] = NOMINAL,
+#endif
+#endif
+};
+
+calibrationFactor calibration_factor[ADC_CHANNELS];
+
+void calibration_init(void){
+    for(int ch = 0; ch < ADC_CHANNELS; ch++){
+        double gain = channel_calibration[ch].gain;
+        double angle = channel_calibration[ch].phase_deg * M_PI / 180.0;
+#if RELAY_NUMERIC == RELAY_NUMERIC_FIXED
+        calibration_factor[ch].real = (int32_t)lround(gain * cos(angle) * (1 << CALIBRATION_SHIFT));
+        calibration_factor[ch].img = (int32_t)lround(gain * sin(angle) * (1 << CALIBRATION_SHIFT));
+#else
+        calibration_factor[ch].real = (real_t)(gain * cos(angle));
+        calibration_factor[ch].img = (real_t)(gain * sin(angle));
+#endif
+    }
+}
+
+#endif
@@ -0,0 +1,148 @@
+#include <string.h>
+
+#include "main.h"
+
+// Every table below is expanded from the curve lists and folded by the compiler,
+// nothing is computed at boot and nothing lives in RAM
+
+// The CO list is in ms as published, its coefficients come into seconds here
+#define MS 0.001
+
+#define CO_CONSTANTS(name, T, K, C, P, R, TR) [name] = { .form = FORM_CO, .constT = (T) * MS, .constK = (K) * MS, .constC = C, .constP = P, .constR = (R) * MS, .constTR = (TR) * MS },
+#define IEC_CONSTANTS(name, K, A, TR) [name] = { .form = FORM_INVERSE, .constT = 0.0, .constK = K, .constP = A, .constTR = TR },
+#define IEEE_CONSTANTS(name, A, B, P, TR) [name] = { .form = FORM_INVERSE, .constT = B, .constK = A, .constP = P, .constTR = TR },
+
+const constTable ktable[CURVE_COUNT] = {
+    CO_CURVES(CO_CONSTANTS)
+    IEC_CURVES(IEC_CONSTANTS)
+    IEEE_CURVES(IEEE_CONSTANTS)
+};
+
+// Integer exponents are plain multiplies, only the 0.02 of the standard inverse
+// curves needs pow and GCC folds that as well when both arguments are constants
+#define CURVE_POW(x, P) ((P) == 1 ? (x) : (P) == 2 ? (x) * (x) : (P) == 3 ? (x) * (x) * (x) : pow(x, P))
+
+// Trip time at the base time dial of each form, in seconds like the rates
+#define CO_TIME(psm, T, K, C, P, R, TR) \
+    (((psm) >= 1.5 ? (T) + (K) / CURVE_POW((psm) - (C), P) : (R) / ((psm) - 1)) * MS)
+#define IEC_TIME(psm, K, A, TR) ((K) / (CURVE_POW(psm, A) - 1))
+#define IEEE_TIME(psm, A, B, P, TR) ((A) / (CURVE_POW(psm, P) - 1) + (B))
+
+// One table point, PSM 1.0 never trips so it gets no progress
+#define CURVE_POINT(psm, time) ((psm) == 1.0 ? (rate_t)0 : RATE(65535.0 / (time)))
+#define CO_POINT(psm, ...) CURVE_POINT(psm, CO_TIME(psm, __VA_ARGS__))
+#define IEC_POINT(psm, ...) CURVE_POINT(psm, IEC_TIME(psm, __VA_ARGS__))
+#define IEEE_POINT(psm, ...) CURVE_POINT(psm, IEEE_TIME(psm, __VA_ARGS__))
+
+// One reset point, the disc winds back over TR/(1 - M^2) seconds from full travel
+#define RESET_POINT(psm2, tr) ((tr) == 0 ? RESET_INSTANT : RATE(65535.0 * (1.0 - (psm2)) / (tr)))
+#define CO_RESET(psm2, T, K, C, P, R, TR) RESET_POINT(psm2, (TR) * MS)
+#define IEC_RESET(psm2, K, A, TR) RESET_POINT(psm2, TR)
+#define IEEE_RESET(psm2, A, B, P, TR) RESET_POINT(psm2, TR)
+
+#define CO_ROW(name, ...) [name] = { PSM_BREAKPOINTS(CO_POINT, __VA_ARGS__), RESET_BREAKPOINTS(CO_RESET, __VA_ARGS__) },
+#define IEC_ROW(name, ...) [name] = { PSM_BREAKPOINTS(IEC_POINT, __VA_ARGS__), RESET_BREAKPOINTS(IEC_RESET, __VA_ARGS__) },
+#define IEEE_ROW(name, ...) [name] = { PSM_BREAKPOINTS(IEEE_POINT, __VA_ARGS__), RESET_BREAKPOINTS(IEEE_RESET, __VA_ARGS__) },
+
+const rate_t curveRates[CURVE_COUNT][CURVE_ROW] = {
+    CO_CURVES(CO_ROW)
+    IEC_CURVES(IEC_ROW)
+    IEEE_CURVES(IEEE_ROW)
+};
+
+// One evaluator per curve with its coefficients built in, so every exponent is
+// a constant and the integer ones compile down to multiplies
+#define CO_EVALUATOR(name, ...) static double name##_time(double psm){ return CO_TIME(psm, __VA_ARGS__); }
+#define IEC_EVALUATOR(name, ...) static double name##_time(double psm){ return IEC_TIME(psm, __VA_ARGS__); }
+#define IEEE_EVALUATOR(name, ...) static double name##_time(double psm){ return IEEE_TIME(psm, __VA_ARGS__); }
+
+CO_CURVES(CO_EVALUATOR)
+IEC_CURVES(IEC_EVALUATOR)
+IEEE_CURVES(IEEE_EVALUATOR)
+
+#define CURVE_EVALUATOR(name, ...) [name] = name##_time,
+
+static double (*const curveTime[CURVE_COUNT])(double psm) = {
+    CO_CURVES(CURVE_EVALUATOR)
+    IEC_CURVES(CURVE_EVALUATOR)
+    IEEE_CURVES(CURVE_EVALUATOR)
+};
+
+// Progress rate at a PSM squared, linear between the semi-log breakpoints
+// The octave and the step come straight out of the exponent and top mantissa bits
+rate_t curveLookup(const rate_t *table, psm2_t psm2){
+#if RELAY_NUMERIC == RELAY_NUMERIC_FIXED
+    // Below pickup
+    if(psm2 < (1u << 16)){
+        return table[0];
+    }
+    uint32_t lead = 31 - __builtin_clz(psm2);
+    uint32_t octave = lead - 16;
+    uint32_t mantissa = psm2 << (31 - lead);
+    uint32_t step = (mantissa >> (31 - PSM2_STEP_BITS)) & (PSM2_STEPS - 1);
+    uint32_t frac = (mantissa >> (31 - PSM2_STEP_BITS - 16)) & 0xFFFF;
+#elif RELAY_NUMERIC == RELAY_NUMERIC_FLOAT
+    uint32_t bits;
+    memcpy(&bits, &psm2, sizeof(bits));
+    int32_t octave = (int32_t)(bits >> 23) - 127;
+    if(octave < 0){
+        return table[0];
+    }
+    uint32_t step = (bits >> (23 - PSM2_STEP_BITS)) & (PSM2_STEPS - 1);
+    real_t frac = (real_t)(bits & ((1u << (23 - PSM2_STEP_BITS)) - 1)) * ((real_t)1.0 / (1u << (23 - PSM2_STEP_BITS)));
+#else
+    uint64_t bits;
+    memcpy(&bits, &psm2, sizeof(bits));
+    int32_t octave = (int32_t)(bits >> 52) - 1023;
+    if(octave < 0){
+        return table[0];
+    }
+    uint32_t step = (uint32_t)(bits >> (52 - PSM2_STEP_BITS)) & (PSM2_STEPS - 1);
+    real_t frac = (real_t)(bits & ((1ull << (52 - PSM2_STEP_BITS)) - 1)) * ((real_t)1.0 / (1ull << (52 - PSM2_STEP_BITS)));
+#endif
+
+    // Heavy faults past the last point run at the last rate, the curves are flat there anyway
+    if(octave >= PSM2_OCTAVES){
+        return table[CURVE_POINTS - 1];
+    }
+
+    uint32_t i = octave * PSM2_STEPS + step;
+    rate_t lo = table[i];
+    rate_t hi = table[i + 1];
+#if RELAY_NUMERIC == RELAY_NUMERIC_FIXED
+    return lo + (rate_t)(((int64_t)hi - lo) * frac >> 16);
+#else
+    return lo + (hi - lo) * frac;
+#endif
+}
+
+// Rate the progress winds back at below pickup, linear between the even breakpoints
+rate_t resetLookup(const rate_t *table, psm2_t psm2){
+    const rate_t *reset = &table[CURVE_POINTS];
+#if RELAY_NUMERIC == RELAY_NUMERIC_FIXED
+    // At pickup the disc stands still
+    if(psm2 >= (1u << 16)){
+        return reset[RESET_POINTS - 1];
+    }
+    uint32_t i = psm2 >> (16 - PSM2_STEP_BITS);
+    uint32_t frac = (psm2 << PSM2_STEP_BITS) & 0xFFFF;
+    rate_t lo = reset[i];
+    rate_t hi = reset[i + 1];
+    return lo + (rate_t)(((int64_t)hi - lo) * frac >> 16);
+#else
+    if(psm2 >= (real_t)1.0){
+        return reset[RESET_POINTS - 1];
+    }
+    real_t pos = psm2 * (real_t)PSM2_STEPS;
+    uint32_t i = (uint32_t)pos;
+    real_t frac = pos - (real_t)i;
+    rate_t lo = reset[i];
+    rate_t hi = reset[i + 1];
+    return lo + (hi - lo) * frac;
+#endif
+}
+
+// Calculate the expected relay trip time in seconds, the reference for the tables
+double getTime(const relayType *curRelay, double current_PSM){
+    return curveTime[curRelay->type](current_PSM) * (curRelay->time_delay/CURVE_BASE_DELAY);
+}
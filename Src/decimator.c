@@ -0,0 +1,81 @@
+#include "main.h"
+
+#if RELAY_OVERSAMPLE > 1
+
+// The conversions themselves and mid rail in their codes
+#define RAW_BITS 12
+#define RAW_MID (1u << (RAW_BITS - 1))
+
+// Mid rail of the decimated codes
+#define SCAN_MID ((uint32_t)(ADC_FULL_SCALE + 1) / 2)
+
+// Two integrators and the two comb delays per channel, modulo 2^32 on purpose, a CIC
+// only needs its output to fit and the burst sums to at most 4095 * RELAY_OVERSAMPLE^2
+static uint32_t integrator1[ADC_CHANNELS];
+static uint32_t integrator2[ADC_CHANNELS];
+static uint32_t comb1[ADC_CHANNELS];
+static uint32_t comb2[ADC_CHANNELS];
+static bool primed = false;
+
+// Q16 from the CIC gain of RELAY_OVERSAMPLE^2 raw codes to ADC_BITS codes, droop included
+static int32_t scale_q16;
+
+// sin(pi h / N) / (R sin(pi h / (N R))) squared, the CIC at harmonic h of the fundamental
+static double response(int harmonic){
+    double angle = M_PI * harmonic / sample_times;
+    double ratio = sin(angle) / (RELAY_OVERSAMPLE * sin(angle / RELAY_OVERSAMPLE));
+    return ratio * ratio;
+}
+
+void decimator_init(void){
+    double gain = (double)RELAY_OVERSAMPLE * RELAY_OVERSAMPLE * response(1);
+    scale_q16 = (int32_t)lround(ldexp(1.0, 16 + ADC_BITS - RAW_BITS) / gain);
+}
+
+double decimatorRelative(int harmonic){
+    return response(1) / response(harmonic);
+}
+
+// The filter settled on the first conversion of every channel, two bursts of it fill
+// both stages so the first scans are not a step up from 0
+static void prime(const uint16_t *first){
+    for(int round = 0; round < 2; round++){
+        for(int ch = 0; ch < ADC_CHANNELS; ch++){
+            for(int s = 0; s < RELAY_OVERSAMPLE; s++){
+                integrator1[ch] += first[ch];
+                integrator2[ch] += integrator1[ch];
+            }
+            uint32_t difference = integrator2[ch] - comb1[ch];
+            comb1[ch] = integrator2[ch];
+            comb2[ch] = difference;
+        }
+    }
+    primed = true;
+}
+
+void decimatorBurst(const uint16_t *burst, uint16_t *scan){
+    if(!primed){
+        prime(burst);
+    }
+    for(int s = 0; s < RELAY_OVERSAMPLE; s++){
+        const uint16_t *raw = &burst[s * ADC_CHANNELS];
+        for(int ch = 0; ch < ADC_CHANNELS; ch++){
+            integrator1[ch] += raw[ch];
+            integrator2[ch] += integrator1[ch];
+        }
+    }
+    for(int ch = 0; ch < ADC_CHANNELS; ch++){
+        uint32_t difference = integrator2[ch] - comb1[ch];
+        comb1[ch] = integrator2[ch];
+        uint32_t sum = difference - comb2[ch];
+        comb2[ch] = difference;
+
+        // Around mid rail so the droop does not move the bias, clipped to the codes there are
+        int32_t centred = (int32_t)(sum - RAW_MID * RELAY_OVERSAMPLE * RELAY_OVERSAMPLE);
+        int32_t code = (int32_t)SCAN_MID + ((centred * scale_q16 + (1 << 15)) >> 16);
+        code = code < 0 ? 0 : code > (int32_t)ADC_FULL_SCALE ? (int32_t)ADC_FULL_SCALE : code;
+        scan[ch] = (uint16_t)code;
+    }
+}
+
+#endif
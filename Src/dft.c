@@ -0,0 +1,205 @@
+#include "main.h"
+#include "trig_tables.h"
+#include "simd.h"
+
+#if RELAY_NUMERIC == RELAY_NUMERIC_FIXED && sample_times % 2
+#error "The packed DFT needs an even number of samples per cycle"
+#endif
+
+// Sine over a cycle and a quarter, folded at compile time into flash
+const twiddle_t trig_table[sample_times + sample_times/4] = { TRIG_TABLE_VALUES };
+
+// Full cycle DFT filter, correlates a whole cycle at once
+// Scalar reference of one channel, getFilteredBank is the one on the hot path
+complexNum getFiltered(sample_t *adc_t, const twiddle_t *cos_table, const twiddle_t *sin_table){
+
+    complexNum result;
+
+#if RELAY_NUMERIC == RELAY_NUMERIC_FIXED
+    // Counts times Q15 twiddles, single cycle MACs into 64 bits
+    acc_t acc_real = 0;
+    acc_t acc_img = 0;
+
+    for(int i = 0; i < sample_times; i++){
+
+        acc_real += (int32_t)adc_t[i]*cos_table[i];
+
+        acc_img -= (int32_t)adc_t[i]*sin_table[i];
+    }
+    result.real = (phasor_t)((acc_real * 2)/sample_times);
+    result.img = (phasor_t)((acc_img * 2)/sample_times);
+#else
+    result.real = 0;
+    result.img = 0;
+
+    for(int i = 0; i < sample_times; i++){
+
+        result.real += adc_t[i]*cos_table[i];
+
+        result.img += adc_t[i]*-sin_table[i];
+    }
+    result.real *= (real_t)2.00/sample_times;
+    result.img *= (real_t)2.00/sample_times;
+#endif
+
+    return result;
+
+}
+
+// Full cycle DFT of every channel in one pass, each twiddle is loaded once for all channels
+void getFilteredBank(sample_t (*samples)[sample_times], complexNum *phasors, const twiddle_t *cos_table, const twiddle_t *sin_table){
+    acc_t acc_real[ADC_CHANNELS] = {0};
+    acc_t acc_img[ADC_CHANNELS] = {0};
+
+#if RELAY_NUMERIC == RELAY_NUMERIC_FIXED
+    // Two neighbouring samples of a channel against two twiddles per dual MAC,
+    // the rows are channel major so a pair of samples is one word
+    for(int i = 0; i < sample_times; i += 2){
+        packed16_t c = loadPacked(&cos_table[i]);
+        packed16_t s = loadPacked(&sin_table[i]);
+        for(int ch = 0; ch < ADC_CHANNELS; ch++){
+            packed16_t x = loadPacked(&samples[ch][i]);
+            acc_real[ch] = dualMac(acc_real[ch], x, c);
+            acc_img[ch] = dualMac(acc_img[ch], x, s);
+        }
+    }
+
+    for(int ch = 0; ch < ADC_CHANNELS; ch++){
+        // The sine was added so negate it here, the sum is exact so this matches getFiltered
+        phasors[ch].real = (phasor_t)((acc_real[ch] * 2)/sample_times);
+        phasors[ch].img = (phasor_t)((-acc_img[ch] * 2)/sample_times);
+    }
+#else
+    for(int i = 0; i < sample_times; i++){
+        twiddle_t c = cos_table[i];
+        twiddle_t s = sin_table[i];
+        for(int ch = 0; ch < ADC_CHANNELS; ch++){
+            acc_t x = samples[ch][i];
+            acc_real[ch] += x * c;
+            acc_img[ch] -= x * s;
+        }
+    }
+
+    for(int ch = 0; ch < ADC_CHANNELS; ch++){
+        phasors[ch].real = acc_real[ch] * ((real_t)2.00/sample_times);
+        phasors[ch].img = acc_img[ch] * ((real_t)2.00/sample_times);
+    }
+#endif
+}
+
+#if RELAY_DFT == RELAY_DFT_SLIDING
+
+// Start the windows empty, the phasors ramp up over the first cycle
+void slidingReset(slidingBank *bank){
+    for(int ch = 0; ch < ADC_CHANNELS; ch++){
+        for(int i = 0; i < sample_times; i++){
+            bank->window[ch][i] = 0;
+        }
+        bank->real[ch] = 0;
+        bank->img[ch] = 0;
+        bank->anchor_real[ch] = 0;
+        bank->anchor_img[ch] = 0;
+    }
+    bank->index = 0;
+}
+
+// Recursive sliding DFT of every channel, one new scan in and the oldest one out
+// The twiddles do not rotate with the window so at every cycle boundary the
+// result is exactly what getFiltered gives for that cycle
+void slidingUpdate(slidingBank *bank, const sample_t *scan, complexNum *phasors, const twiddle_t *cos_table, const twiddle_t *sin_table){
+    uint8_t k = bank->index;
+
+    // All channels share the twiddle of this scan
+    twiddle_t c = cos_table[k];
+    twiddle_t s = sin_table[k];
+
+    for(int ch = 0; ch < ADC_CHANNELS; ch++){
+        // The sample leaving the window has the same twiddle as the one entering
+#if RELAY_NUMERIC == RELAY_NUMERIC_FIXED
+        int32_t value = scan[ch];
+        int32_t delta = value - bank->window[ch][k];
+#else
+        acc_t value = scan[ch];
+        acc_t delta = value - bank->window[ch][k];
+#endif
+        bank->window[ch][k] = scan[ch];
+
+        bank->real[ch] += (acc_t)(delta * c);
+        bank->img[ch] -= (acc_t)(delta * s);
+
+        // Shadow sum of the current cycle only, it never sees a subtraction
+        bank->anchor_real[ch] += (acc_t)(value * c);
+        bank->anchor_img[ch] -= (acc_t)(value * s);
+    }
+
+    k++;
+    if(k == sample_times){
+        // Re-anchor on the exact correlation so rounding never accumulates
+        for(int ch = 0; ch < ADC_CHANNELS; ch++){
+            bank->real[ch] = bank->anchor_real[ch];
+            bank->img[ch] = bank->anchor_img[ch];
+            bank->anchor_real[ch] = 0;
+            bank->anchor_img[ch] = 0;
+        }
+        k = 0;
+    }
+    bank->index = k;
+
+    for(int ch = 0; ch < ADC_CHANNELS; ch++){
+#if RELAY_NUMERIC == RELAY_NUMERIC_FIXED
+        phasors[ch].real = (phasor_t)((bank->real[ch] * 2)/sample_times);
+        phasors[ch].img = (phasor_t)((bank->img[ch] * 2)/sample_times);
+#else
+        phasors[ch].real = bank->real[ch] * ((real_t)2.00/sample_times);
+        phasors[ch].img = bank->img[ch] * ((real_t)2.00/sample_times);
+#endif
+    }
+}
+
+#endif
+
+#if RELAY_HARMONIC
+
+void getHarmonicBank(sample_t (*samples)[sample_times], complexNum (*harmonics)[HARMONICS], const twiddle_t (*cos_rows)[sample_times], const twiddle_t (*sin_rows)[sample_times]){
+    acc_t acc_real[ADC_CHANNELS][HARMONICS] = {{0}};
+    acc_t acc_img[ADC_CHANNELS][HARMONICS] = {{0}};
+
+#if RELAY_NUMERIC == RELAY_NUMERIC_FIXED
+    // The same dual MACs as getFilteredBank, a pair of samples is loaded once for every row
+    for(int i = 0; i < sample_times; i += 2){
+        for(int ch = 0; ch < ADC_CHANNELS; ch++){
+            packed16_t x = loadPacked(&samples[ch][i]);
+            for(int h = 0; h < HARMONICS; h++){
+                acc_real[ch][h] = dualMac(acc_real[ch][h], x, loadPacked(&cos_rows[h][i]));
+                acc_img[ch][h] = dualMac(acc_img[ch][h], x, loadPacked(&sin_rows[h][i]));
+            }
+        }
+    }
+
+    for(int ch = 0; ch < ADC_CHANNELS; ch++){
+        for(int h = 0; h < HARMONICS; h++){
+            harmonics[ch][h].real = (phasor_t)((acc_real[ch][h] * 2)/sample_times);
+            harmonics[ch][h].img = (phasor_t)((-acc_img[ch][h] * 2)/sample_times);
+        }
+    }
+#else
+    for(int i = 0; i < sample_times; i++){
+        for(int ch = 0; ch < ADC_CHANNELS; ch++){
+            acc_t x = samples[ch][i];
+            for(int h = 0; h < HARMONICS; h++){
+                acc_real[ch][h] += x * cos_rows[h][i];
+                acc_img[ch][h] -= x * sin_rows[h][i];
+            }
+        }
+    }
+
+    for(int ch = 0; ch < ADC_CHANNELS; ch++){
+        for(int h = 0; h < HARMONICS; h++){
+            harmonics[ch][h].real = acc_real[ch][h] * ((real_t)2.00/sample_times);
+            harmonics[ch][h].img = acc_img[ch][h] * ((real_t)2.00/sample_times);
+        }
+    }
+#endif
+}
+
+#endif
@@ -0,0 +1,140 @@
+#include "main.h"
+
+directionalStats directional_stats;
+
+// The directional score that determines if forward or backward
+bool isForward(complexNum voltage, complexNum current, twiddle_t C_setting, twiddle_t S_setting){
+    power_t P_meas = ((power_t)voltage.real * current.real) + ((power_t)voltage.img * current.img);
+    power_t Q_meas = ((power_t)voltage.real * current.img) - ((power_t)voltage.img * current.real);
+
+#if RELAY_NUMERIC == RELAY_NUMERIC_FIXED
+    // Drop the Q15 before the torque angle multiply so nothing overflows, only the sign matters
+    P_meas >>= 15;
+    Q_meas >>= 15;
+#endif
+
+    power_t directional_score = (P_meas * C_setting) + (Q_meas * S_setting);
+    return directional_score > 0;
+}
+
+#if RELAY_MEMORY
+
+// Cycles kept per phase. The oldest polarizes, a fault late in a cycle can leave
+// that cycle healthy enough to be stored but never the one before it
+#define MEMORY_DEPTH 2
+
+typedef struct {
+    float real[MEMORY_DEPTH];   // Peak volts at the pin, turned up to the cycle running
+    float img[MEMORY_DEPTH];
+    uint8_t slot;               // Next entry written, the oldest once the ring is full
+    uint8_t filled;
+    uint8_t age;                // Cycles since the last refresh
+    bool valid;
+    complexNum polar;           // The oldest entry in the units of the phasors
+    int8_t held;                // Direction found on the memory, -1 when none
+} voltageMemory;
+
+static voltageMemory memory[RELAY_PHASES];
+
+// MEMORY_MIN_VOLTS in the units of a phasor magnitude squared
+static power_t collapsed;
+
+void directional_init(void){
+    collapsed = toPower(MEMORY_MIN_VOLTS);
+    for(int p = 0; p < RELAY_PHASES; p++){
+        memory[p].held = -1;
+    }
+}
+
+void directionalCycle(const complexNum *voltages, bool quiet){
+    // The phasors turn by 2 pi (window / period - 1) a cycle, the window is what the
+    // trigger timer takes for a cycle of triggers and the period the tracked one,
+    // both as the tracker just set them for the next cycle
+    float window = TRIGGER_WINDOW(__HAL_TIM_GET_AUTORELOAD(&adc_trigger));
+    float period = (float)freq_tracker.period_q8 / 256.0f;
+    float turn = 2.0f * (float)M_PI * (window / period - 1.0f);
+    float c = cosf(turn);
+    float s = sinf(turn);
+
+    for(int p = 0; p < RELAY_PHASES; p++){
+        voltageMemory *m = &memory[p];
+        float real = (float)(voltages[p].real / PHASOR_PER_VOLT);
+        float img = (float)(voltages[p].img / PHASOR_PER_VOLT);
+        bool healthy = real * real + img * img > (float)(MEMORY_MIN_VOLTS * MEMORY_MIN_VOLTS);
+        if(quiet && healthy){
+            m->real[m->slot] = real;
+            m->img[m->slot] = img;
+            m->slot = (m->slot + 1) % MEMORY_DEPTH;
+            if(m->filled < MEMORY_DEPTH){
+                m->filled++;
+            }
+            m->age = 0;
+            directional_stats.stored++;
+        } else if(m->age < MEMORY_CYCLES){
+            m->age++;
+        }
+
+        // Everything kept is then where the phasors of the cycle to come will be
+        for(int i = 0; i < m->filled; i++){
+            float turned = m->real[i] * c - m->img[i] * s;
+            m->img[i] = m->real[i] * s + m->img[i] * c;
+            m->real[i] = turned;
+        }
+
+        // Both halves of the polarizing phasor at once for a decision in interrupt context
+        bool valid = m->filled == MEMORY_DEPTH && m->age < MEMORY_CYCLES;
+        complexNum polar = {
+            .real = (phasor_t)(m->real[m->slot] * PHASOR_PER_VOLT),
+            .img = (phasor_t)(m->img[m->slot] * PHASOR_PER_VOLT),
+        };
+        protectionLock();
+        m->valid = valid;
+        if(valid){
+            m->polar = polar;
+        }
+        protectionUnlock();
+    }
+}
+
+void directionalDropout(int e){
+    if(e < RELAY_PHASES){
+        memory[e].held = -1;
+    }
+}
+
+bool phaseForward(int e, complexNum voltage, complexNum current, const compiledSettings *settings, polarSource *source){
+    voltageMemory *m = &memory[e];
+    power_t magnitude = (power_t)voltage.real * voltage.real + (power_t)voltage.img * voltage.img;
+
+    if(magnitude >= collapsed){
+        m->held = -1;
+        *source = POLAR_MEASURED;
+        return isForward(voltage, current, settings->cos_angle, settings->sin_angle);
+    }
+    if(m->valid){
+        bool forward = isForward(m->polar, current, settings->cos_angle, settings->sin_angle);
+        m->held = forward;
+        directional_stats.memory++;
+        *source = POLAR_MEMORY;
+        return forward;
+    }
+    if(m->held >= 0){
+        directional_stats.held++;
+        *source = POLAR_HELD;
+        return m->held;
+    }
+    // Closed onto a fault with no voltage before it, the instantaneous element is what clears it
+    directional_stats.blocked++;
+    *source = POLAR_NONE;
+    return false;
+}
+
+#else
+
+bool phaseForward(int e, complexNum voltage, complexNum current, const compiledSettings *settings, polarSource *source){
+    (void)e;
+    *source = POLAR_MEASURED;
+    return isForward(voltage, current, settings->cos_angle, settings->sin_angle);
+}
+
+#endif
@@ -0,0 +1,202 @@
+#include "main.h"
+
+frequencyTracker freq_tracker = {
+    .period_q8 = 20000u << 8,
+    .source = FREQ_HOLD,
+};
+
+// Capture periods outside the tracked range in timer ticks
+#define MIN_TICKS ((uint32_t)(CAPTURE_TICKS_PER_US * 1000000.0 / FREQUENCY_MAX_HZ))
+#define MAX_TICKS ((uint32_t)(CAPTURE_TICKS_PER_US * 1000000.0 / FREQUENCY_MIN_HZ))
+
+// Consecutive dropped crossings before the average is thrown away and relearned,
+// a real change of frequency looks like noise to the average at first
+#define RELOCK_STREAK 4
+
+// Cycles without a good crossing before the comparator is taken as lost
+#define CAPTURE_TIMEOUT 3
+
+// The crossings and the phasor agree within this fraction of a period
+#define AGREE_SHIFT 7
+
+// Smallest VA the phasor estimate runs on, peak volts at the pin
+#define PHASOR_MIN_VOLTS 0.1
+
+// Only the capture interrupt writes these
+static uint32_t last_edge;
+static bool have_edge = false;
+static uint32_t periods[FREQUENCY_AVERAGE];
+static uint32_t period_sum;
+static uint8_t period_slot;
+static uint8_t period_count;
+static uint8_t reject_streak;
+
+// What the interrupt hands to the main loop, a single word each
+static volatile uint32_t capture_q8;
+static volatile uint32_t capture_edges;
+
+void frequencyCapture(uint32_t stamp){
+    if(!have_edge){
+        last_edge = stamp;
+        have_edge = true;
+        return;
+    }
+
+    // Wraps with the 32 bit counter, every 51 seconds
+    uint32_t period = stamp - last_edge;
+    bool locked = period_count == FREQUENCY_AVERAGE;
+    uint32_t average = period_sum / FREQUENCY_AVERAGE;
+    uint32_t tolerance = average >> 4;
+
+    // A second crossing on noise, keep timing from the last good one
+    if(period < MIN_TICKS || (locked && period + tolerance < average)){
+        freq_tracker.capture_rejects++;
+        if(++reject_streak >= RELOCK_STREAK){
+            period_count = 0;
+        }
+        return;
+    }
+
+    last_edge = stamp;
+
+    // A crossing went missing, time again from this one
+    if(period > MAX_TICKS || (locked && period > average + tolerance)){
+        freq_tracker.capture_rejects++;
+        if(++reject_streak >= RELOCK_STREAK){
+            period_count = 0;
+        }
+        return;
+    }
+
+    reject_streak = 0;
+    if(period_count < FREQUENCY_AVERAGE){
+        // Relearning, start the average over
+        if(!period_count){
+            period_sum = 0;
+            period_slot = 0;
+        }
+        period_count++;
+    } else {
+        period_sum -= periods[period_slot];
+    }
+    periods[period_slot] = period;
+    period_sum += period;
+    period_slot = (period_slot + 1) % FREQUENCY_AVERAGE;
+
+    if(period_count == FREQUENCY_AVERAGE){
+        capture_q8 = (uint32_t)(((uint64_t)period_sum << 8) / (CAPTURE_TICKS_PER_US * FREQUENCY_AVERAGE));
+        capture_edges++;
+    }
+}
+
+// The main loop side
+static uint32_t seen_edges;
+static uint8_t quiet_cycles = CAPTURE_TIMEOUT;
+static float last_real;
+static float last_img;
+static bool have_phasor = false;
+static uint32_t estimates[FREQUENCY_AVERAGE];
+static uint32_t estimate_sum;
+static uint8_t estimate_slot;
+static uint8_t estimate_count;
+static uint32_t phasor_q8;
+static bool have_estimate = false;
+
+// The reload written last, the one the cycle just ended ran on and the one before
+static uint32_t reload;
+static uint32_t cycle_reload;
+static uint32_t span_reload;
+static bool retuned = true;
+static bool cycle_mixed = true;
+static bool span_mixed = true;
+
+// Retune the trigger timer, the preload makes it take effect at the next scan
+static void setPeriod(uint32_t period_q8){
+    const uint32_t min_q8 = (uint32_t)(256.0 * 1000000.0 / FREQUENCY_MAX_HZ);
+    const uint32_t max_q8 = (uint32_t)(256.0 * 1000000.0 / FREQUENCY_MIN_HZ);
+    period_q8 = period_q8 < min_q8 ? min_q8 : period_q8 > max_q8 ? max_q8 : period_q8;
+
+    freq_tracker.period_q8 = period_q8;
+    g_current_period = (period_q8 + 128) >> 8;
+
+    uint32_t next = (period_q8 * TRIGGER_TICKS_PER_US + 128 * TRIGGERS_PER_CYCLE) / (256 * TRIGGERS_PER_CYCLE) - 1;
+    if(next != reload){
+        reload = next;
+        __HAL_TIM_SET_AUTORELOAD(&adc_trigger, next);
+        retuned = true;
+    }
+}
+
+void frequencyCycle(const complexNum *voltage){
+    if(!reload){
+        reload = __HAL_TIM_GET_AUTORELOAD(&adc_trigger);
+    }
+    // The phasors are referenced to the start of their cycle, so the turn from the last
+    // one spans the cycle before this one. A cycle after a retune ran on both reloads
+    span_reload = cycle_reload;
+    span_mixed = cycle_mixed;
+    cycle_reload = reload;
+    cycle_mixed = retuned;
+    retuned = false;
+
+    // Good crossings since the last cycle
+    uint32_t edges = capture_edges;
+    uint32_t capture = capture_q8;
+    if(edges != seen_edges){
+        seen_edges = edges;
+        quiet_cycles = 0;
+    } else if(quiet_cycles < CAPTURE_TIMEOUT){
+        quiet_cycles++;
+    }
+    bool capture_alive = quiet_cycles < CAPTURE_TIMEOUT;
+
+    // The phasor turns by 2 pi (window / period - 1) a cycle, the same twiddles every time
+    float real = (float)(voltage->real / PHASOR_PER_VOLT);
+    float img = (float)(voltage->img / PHASOR_PER_VOLT);
+    bool strong = real * real + img * img > (float)(PHASOR_MIN_VOLTS * PHASOR_MIN_VOLTS);
+    if(strong && have_phasor && !span_mixed){
+        float window = TRIGGER_WINDOW(span_reload);
+        float turn = atan2f(img * last_real - real * last_img, real * last_real + img * last_img);
+        uint32_t estimate = (uint32_t)(256.0f * window / (1.0f + turn / (2.0f * (float)M_PI)));
+        // The same box average as the crossings, so both lag a ramp alike
+        if(estimate_count < FREQUENCY_AVERAGE){
+            estimate_count++;
+        } else {
+            estimate_sum -= estimates[estimate_slot];
+        }
+        estimates[estimate_slot] = estimate;
+        estimate_sum += estimate;
+        estimate_slot = (estimate_slot + 1) % FREQUENCY_AVERAGE;
+        phasor_q8 = estimate_sum / estimate_count;
+        have_estimate = true;
+    } else if(!strong){
+        estimate_count = 0;
+        estimate_sum = 0;
+        have_estimate = false;
+    }
+    have_phasor = strong;
+    last_real = real;
+    last_img = img;
+
+    if(capture_alive && have_estimate){
+        uint32_t diff = capture > phasor_q8 ? capture - phasor_q8 : phasor_q8 - capture;
+        if(diff > capture >> AGREE_SHIFT){
+            // Harmonics or noise moving the crossings, the fundamental is what the DFT needs
+            freq_tracker.disagreements++;
+            freq_tracker.source = FREQ_PHASOR;
+            setPeriod(phasor_q8);
+        } else {
+            freq_tracker.source = FREQ_CAPTURE;
+            setPeriod(capture);
+        }
+    } else if(capture_alive){
+        freq_tracker.source = FREQ_CAPTURE;
+        setPeriod(capture);
+    } else if(have_estimate){
+        freq_tracker.fallbacks++;
+        freq_tracker.source = FREQ_PHASOR;
+        setPeriod(phasor_q8);
+    } else {
+        freq_tracker.source = FREQ_HOLD;
+    }
+}
@@ -0,0 +1,91 @@
+#include "main.h"
+
+#if RELAY_HARMONIC
+
+harmonicStats harmonic_stats;
+
+complexNum harmonics[ADC_CHANNELS][HARMONICS];
+
+#if RELAY_PHASES == 3
+static const uint8_t phase_current[3] = { CH_IA, CH_IB, CH_IC };
+#else
+static const uint8_t phase_current[1] = { CH_IA };
+#endif
+
+#define PHASE_CURRENTS (sizeof(phase_current) / sizeof(phase_current[0]))
+
+// Twiddles of every harmonic, built at boot so each row is contiguous and pairs of them
+// load as one word like the fundamental. The mimic filter's response at each harmonic,
+// relative to the fundamental, is taken out here and costs nothing per cycle
+static twiddle_t cos_rows[HARMONICS][sample_times];
+static twiddle_t sin_rows[HARMONICS][sample_times];
+
+static bool restrained;
+
+restraintSetting restraintCompile(double ratio){
+    restraintSetting setting;
+    // The bank reads the second harmonic through the decimator's droop, which is above
+    // 1 in Q15 for some twiddles, so the setting comes down to it instead
+    ratio /= decimatorRelative(2);
+    // A restraint above a whole fundamental never operates, keep the product in range
+    double squared = ratio < 1.0 ? ratio * ratio : 1.0;
+#if RELAY_NUMERIC == RELAY_NUMERIC_FIXED
+    setting.ratio2 = (uint32_t)(squared * 65536.0);
+#else
+    setting.ratio2 = (real_t)squared;
+#endif
+    return setting;
+}
+
+void harmonic_init(void){
+    for(int h = 0; h < HARMONICS; h++){
+        double a, b;
+        mimicCompensation(h + 2, &a, &b);
+        for(int i = 0; i < sample_times; i++){
+            double angle = 2.0 * M_PI * ((h + 2) * i % sample_times) / sample_times;
+            // The correlation times a + jb, folded into both rows
+            cos_rows[h][i] = toTwiddle(a * cos(angle) + b * sin(angle));
+            sin_rows[h][i] = toTwiddle(a * sin(angle) - b * cos(angle));
+        }
+    }
+}
+
+bool harmonicRestrained(void){
+    return restrained;
+}
+
+static inline power_t magnitude2(complexNum value){
+    return (power_t)value.real * value.real + (power_t)value.img * value.img;
+}
+
+void harmonicCycle(sample_t (*samples)[sample_times], const complexNum *phasors){
+    getHarmonicBank(samples, harmonics, cos_rows, sin_rows);
+    // On the scale of the calibrated fundamentals, or the ratio would carry the gain
+    for(int ch = 0; ch < ADC_CHANNELS; ch++){
+        calibrateChannel(ch, harmonics[ch], HARMONICS);
+    }
+
+    const compiledSettings *settings = settingsActive();
+    bool restrain = false;
+    for(uint32_t p = 0; p < PHASE_CURRENTS && !restrain; p++){
+        complexNum fundamental = phasors[phase_current[p]];
+        // Below pickup a phase has nothing to restrain and its ratio is mostly noise
+        if(getRMSquared(fundamental) <= settings->pickup.squared){
+            continue;
+        }
+        power_t first = magnitude2(fundamental);
+        power_t second = magnitude2(harmonics[phase_current[p]][0]);
+#if RELAY_NUMERIC == RELAY_NUMERIC_FIXED
+        restrain = (uint64_t)second > ((uint64_t)first >> 16) * settings->restraint.ratio2;
+#else
+        restrain = second > first * settings->restraint.ratio2;
+#endif
+    }
+    // A ratio of 0 is off, any noise would be above it
+    restrained = restrain && settings->restraint.ratio2;
+    if(restrained){
+        harmonic_stats.restrained++;
+    }
+}
+
+#endif
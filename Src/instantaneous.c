@@ -0,0 +1,140 @@
+#include "main.h"
+
+#if RELAY_INSTANT
+
+#if sample_times % 4
+#error "The sample pair estimator needs a quarter cycle of whole samples"
+#endif
+
+instantStats instant_stats;
+
+#if RELAY_PHASES == 3
+static const uint8_t phase_current[3] = { CH_IA, CH_IB, CH_IC };
+#else
+static const uint8_t phase_current[1] = { CH_IA };
+#endif
+
+#define PHASE_CURRENTS (sizeof(phase_current) / sizeof(phase_current[0]))
+
+// Time constant of the front end offset in scans, a power of two. Long next to a cycle
+// so a fault offset barely moves it, and frozen while the element is picked up
+#define OFFSET_SHIFT 8
+
+// The last cycle of codes of every phase current and the front end offset, Q8
+static uint16_t window[PHASE_CURRENTS][sample_times];
+static uint32_t offset_q8[PHASE_CURRENTS];
+static uint8_t slot;
+static uint8_t filled;
+
+static uint8_t over;
+static uint8_t under;
+static volatile bool active;
+
+instantSetting instantCompile(double pickup, uint8_t count){
+    instantSetting setting;
+    for(uint32_t p = 0; p < PHASE_CURRENTS; p++){
+        // Peak codes of the pickup in Q8 like the centred samples, as the phase measures it
+        double peak = pickup * M_SQRT2 * (ADC_FULL_SCALE / ADC_VREF) * 256.0 / calibrationGain(phase_current[p]);
+#if RELAY_INSTANT_ESTIMATOR == RELAY_INSTANT_PAIR
+        setting.threshold[p] = (uint64_t)(peak * peak);
+#elif RELAY_INSTANT_ESTIMATOR == RELAY_INSTANT_HALF
+        // The rectified mean of a sine is 2/pi of its peak, summed over half a cycle
+        setting.threshold[p] = (uint64_t)(peak * sample_times / M_PI);
+#else
+        setting.threshold[p] = (uint64_t)peak;
+#endif
+    }
+    setting.security = count ? count : 1;
+    return setting;
+}
+
+void instant_init(void){
+    // The calibrated bias until the average has seen the real one
+    for(uint32_t p = 0; p < PHASE_CURRENTS; p++){
+        offset_q8[p] = (uint32_t)lround(calibrationOffset(phase_current[p]) * (ADC_FULL_SCALE / ADC_VREF) * 256.0);
+    }
+}
+
+bool instantActive(void){
+    return active;
+}
+
+void instantGap(void){
+    filled = 0;
+    over = 0;
+}
+
+// Offset free sample of the given age in scans, Q8
+static inline int32_t centred(int p, int age){
+    return ((int32_t)window[p][(slot + sample_times - age) % sample_times] << 8) - (int32_t)offset_q8[p];
+}
+
+void instantScan(const uint16_t *raw){
+    bool picked_up = false;
+    // Read once, a new bank is published between two scans at the earliest
+    const instantSetting *setting = &settingsActive()->instant;
+    const uint64_t *threshold = setting->threshold;
+    uint8_t security = setting->security;
+
+    for(uint32_t p = 0; p < PHASE_CURRENTS; p++){
+        window[p][slot] = raw[phase_current[p]];
+    }
+
+    // The estimators look back up to half a cycle
+    if(filled < sample_times){
+        filled++;
+        slot = (slot + 1) % sample_times;
+        return;
+    }
+
+    for(uint32_t p = 0; p < PHASE_CURRENTS && !picked_up; p++){
+#if RELAY_INSTANT_ESTIMATOR == RELAY_INSTANT_PAIR
+        // A quarter cycle apart, a sin and a cos of the same peak
+        int64_t now = centred(p, 0);
+        int64_t quarter = centred(p, sample_times / 4);
+        picked_up = (uint64_t)(now * now + quarter * quarter) > threshold[p];
+#elif RELAY_INSTANT_ESTIMATOR == RELAY_INSTANT_HALF
+        uint32_t rectified = 0;
+        for(int age = 0; age < sample_times / 2; age++){
+            int32_t x = centred(p, age);
+            rectified += x < 0 ? -x : x;
+        }
+        picked_up = rectified > threshold[p];
+#else
+        int32_t now = centred(p, 0);
+        picked_up = (uint32_t)(now < 0 ? -now : now) > threshold[p];
+#endif
+    }
+
+    // Only quiet scans move the offset, a fault would drag it along
+    if(!picked_up && !active){
+        for(uint32_t p = 0; p < PHASE_CURRENTS; p++){
+            offset_q8[p] += ((int32_t)window[p][slot] * 256 - (int32_t)offset_q8[p]) >> OFFSET_SHIFT;
+        }
+    }
+    slot = (slot + 1) % sample_times;
+
+    if(picked_up){
+        under = 0;
+        instant_stats.pickups++;
+        if(over < security){
+            over++;
+        }
+        if(over >= security && !active){
+            active = true;
+            instant_stats.operations++;
+            recorderTrigger(RECORDER_CAUSE_TRIP);
+            if(!tripped){
+                quickTrip();
+            }
+        }
+    } else {
+        over = 0;
+        // Hold the trip for a cycle below pickup, the DFT elements take it from there
+        if(active && ++under >= sample_times){
+            active = false;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,134 @@
+#include "main.h"
+
+#if RELAY_PROFILE
+
+latencyStats latency_stats[LAT_STAGES];
+uint32_t latency_overruns = 0;
+
+// Written by the ISR, the last acquisition event
+static volatile uint32_t isr_stamp;
+static bool isr_seen = false;
+
+// End of conversion of the newest scan, every acquisition event and every DMA'd scan
+static volatile uint32_t scan_stamp;
+
+// The acquisition event of the data the main loop is working on
+static uint32_t origin;
+
+// Core clock in cycles per microsecond, g_current_period is in microseconds
+static uint32_t cycles_per_us;
+
+#ifdef RELAY_HOST
+#include <time.h>
+
+// Wall clock stand in, a simulation on virtual time replaces it with its own
+__attribute__((weak)) uint32_t hostCycles(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((uint64_t)now.tv_sec * SystemCoreClock + (uint64_t)now.tv_nsec * (SystemCoreClock / 1000000) / 1000);
+}
+
+// The wall clock already ran while the work was done
+__attribute__((weak)) void hostStage(latencyStage stage){
+    (void)stage;
+}
+#endif
+
+// Start the cycle counter, it wraps every 51 s at 84 MHz which the unsigned differences absorb
+void latency_init(void){
+#ifndef RELAY_HOST
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+    cycles_per_us = SystemCoreClock / 1000000;
+    latencyReset();
+}
+
+void latencyReset(void){
+    for(int s = 0; s < LAT_STAGES; s++){
+        latency_stats[s].min = UINT32_MAX;
+        latency_stats[s].max = 0;
+        latency_stats[s].count = 0;
+        for(int b = 0; b < LATENCY_BINS; b++){
+            latency_stats[s].histogram[b] = 0;
+        }
+    }
+    latency_overruns = 0;
+    isr_seen = false;
+}
+
+static void record(latencyStats *stats, uint32_t cycles){
+    if(cycles < stats->min){
+        stats->min = cycles;
+    }
+    if(cycles > stats->max){
+        stats->max = cycles;
+    }
+    stats->count++;
+
+    // The bucket is the bit length, a single CLZ
+    uint32_t bin = cycles ? 32 - __builtin_clz(cycles) : 0;
+    stats->histogram[bin < LATENCY_BINS ? bin : LATENCY_BINS - 1]++;
+}
+
+void latencyMark(latencyStage stage){
+#ifdef RELAY_HOST
+    hostStage(stage);
+#endif
+    uint32_t now = CYCLE_COUNT();
+
+    switch(stage){
+    case LAT_ADC_ISR:
+        // In the ISR the statistic is the time between acquisition events
+        if(isr_seen){
+            record(&latency_stats[LAT_ADC_ISR], now - isr_stamp);
+        }
+        isr_seen = true;
+        isr_stamp = now;
+        scan_stamp = now;
+        return;
+
+    case LAT_BUFFER:
+#if RELAY_DFT == RELAY_DFT_SLIDING
+        origin = scan_stamp;
+#else
+        origin = isr_stamp;
+#endif
+        break;
+
+    case LAT_DECISION: {
+        // One step of budget before the next data is waiting
+#if RELAY_DFT == RELAY_DFT_SLIDING
+        uint32_t budget = g_current_period * cycles_per_us / sample_times;
+#else
+        uint32_t budget = g_current_period * cycles_per_us;
+#endif
+        if(now - origin > budget){
+            latency_overruns++;
+        }
+        break;
+    }
+
+    case LAT_TRIP:
+        // Everything from the last sample on, the ISR and the wait for the DFT included
+        record(&latency_stats[LAT_TRIP], now - scan_stamp);
+        return;
+
+    default:
+        break;
+    }
+
+    record(&latency_stats[stage], now - origin);
+}
+
+void latencyScan(void){
+    scan_stamp = CYCLE_COUNT();
+}
+
+uint32_t latencyTripWorst(void){
+    // Rounded up, a trip inside a microsecond is not one that never happened
+    return (latency_stats[LAT_TRIP].max + cycles_per_us - 1) / cycles_per_us;
+}
+
+#endif
@@ -0,0 +1,89 @@
+#include "main.h"
+
+// (1 + tau) - tau e^(-j h theta), the response without K at harmonic h
+static void response(double tau, int harmonic, double *real, double *img){
+    double angle = 2.0 * M_PI * harmonic / sample_times;
+    *real = 1.0 + tau - tau * cos(angle);
+    *img = tau * sin(angle);
+}
+
+void mimicDesign(mimicFilter *filter, double tau_ms, uint32_t period_us){
+    double tau = tau_ms * 1000.0 * sample_times / period_us;
+    double real, img;
+    response(tau, 1, &real, &img);
+    double gain = 1.0 / sqrt(real * real + img * img);
+    filter->tau = tau;
+#if RELAY_NUMERIC == RELAY_NUMERIC_FIXED
+    filter->b0 = (int32_t)lround(gain * (1.0 + tau) * (1 << MIMIC_SHIFT));
+    filter->b1 = (int32_t)lround(-gain * tau * (1 << MIMIC_SHIFT));
+#else
+    filter->b0 = (real_t)(gain * (1.0 + tau));
+    filter->b1 = (real_t)(-gain * tau);
+#endif
+}
+
+void mimicRelative(const mimicFilter *filter, int harmonic, double *real, double *img){
+    double r1, i1, rh, ih;
+    response(filter->tau, 1, &r1, &i1);
+    response(filter->tau, harmonic, &rh, &ih);
+    double norm = rh * rh + ih * ih;
+    // The fundamental over the harmonic, the gain K cancels
+    *real = (r1 * rh + i1 * ih) / norm;
+    *img = (i1 * rh - r1 * ih) / norm;
+}
+
+#if RELAY_DC_FILTER == RELAY_DC_MIMIC
+
+static mimicFilter relay_filter;
+
+// The input before the one filtered next, per channel
+static sample_t last[ADC_CHANNELS];
+static bool primed = false;
+
+void mimic_init(uint32_t period_us){
+    mimicDesign(&relay_filter, DC_TAU_MS, period_us);
+}
+
+// The first sample stands in for the one before it, the bias is then not a step
+static inline void prime(const sample_t *first){
+    for(int ch = 0; ch < ADC_CHANNELS; ch++){
+        last[ch] = first[ch];
+    }
+    primed = true;
+}
+
+void mimicScan(sample_t *scan){
+    if(!primed){
+        prime(scan);
+    }
+    for(int ch = 0; ch < ADC_CHANNELS; ch++){
+        sample_t x = scan[ch];
+        scan[ch] = mimicStep(&relay_filter, x, last[ch]);
+        last[ch] = x;
+    }
+}
+
+void mimicCycle(sample_t (*samples)[sample_times]){
+    if(!primed){
+        sample_t first[ADC_CHANNELS];
+        for(int ch = 0; ch < ADC_CHANNELS; ch++){
+            first[ch] = samples[ch][0];
+        }
+        prime(first);
+    }
+    for(int ch = 0; ch < ADC_CHANNELS; ch++){
+        sample_t before = last[ch];
+        for(int i = 0; i < sample_times; i++){
+            sample_t x = samples[ch][i];
+            samples[ch][i] = mimicStep(&relay_filter, x, before);
+            before = x;
+        }
+        last[ch] = before;
+    }
+}
+
+void mimicCompensation(int harmonic, double *real, double *img){
+    mimicRelative(&relay_filter, harmonic, real, img);
+}
+
+#endif
@@ -0,0 +1,163 @@
+#include "main.h"
+
+#if RELAY_RECORDER
+
+recorderImage disturbance;
+
+#define RING_MASK (RECORDER_BYTES - 1)
+#define HISTORY (RECORDER_PRE_CYCLES + 1)
+
+// Only the interrupt moves these, the main loop reads the header once the record is done
+static volatile uint8_t state;
+static uint32_t head;                   // Bytes written since armed, the ring offset is the low bits
+static uint32_t block_start[HISTORY];   // Where the latest blocks start, in the same count as head
+static uint8_t slot;                    // Next entry of block_start
+static uint16_t history;                // Blocks in block_start, up to RECORDER_PRE_CYCLES
+static uint32_t record_start;
+static uint16_t post_left;
+
+// The one thing the main loop writes, taken by the interrupt at the next cycle
+static volatile uint8_t trigger_request;
+
+typedef struct {
+    uint32_t pos;
+    uint32_t acc;
+    uint32_t bits;
+} bitWriter;
+
+// LSB first into the ring, at most 15 bits a call so the accumulator never overflows
+static inline void putBits(bitWriter *w, uint32_t value, uint32_t bits){
+    w->acc |= value << w->bits;
+    w->bits += bits;
+    while(w->bits >= 8){
+        disturbance.ring[w->pos++ & RING_MASK] = (uint8_t)w->acc;
+        w->acc >>= 8;
+        w->bits -= 8;
+    }
+}
+
+// Small steps of either sign become small unsigned numbers
+static inline uint32_t zigzag(int32_t delta){
+    return ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+}
+
+static void freeze(void){
+    disturbance.header.start = record_start & RING_MASK;
+    disturbance.header.length = head - record_start;
+    disturbance.header.cycles = disturbance.header.pre_cycles + (RECORDER_POST_CYCLES - post_left);
+    disturbance.header.state = RECORDER_DONE;
+    state = RECORDER_DONE;
+}
+
+void recorder_init(void){
+    disturbance.header.magic = RECORDER_MAGIC;
+    disturbance.header.channels = ADC_CHANNELS;
+    disturbance.header.samples = sample_times;
+    disturbance.header.adc_bits = ADC_BITS;
+    disturbance.header.capacity = RECORDER_BYTES;
+    recorderRearm();
+}
+
+void recorderRearm(void){
+    state = RECORDER_DONE;
+    head = 0;
+    slot = 0;
+    history = 0;
+    trigger_request = RECORDER_CAUSE_NONE;
+    disturbance.header.cause = RECORDER_CAUSE_NONE;
+    disturbance.header.cycles = 0;
+    disturbance.header.pre_cycles = 0;
+    disturbance.header.length = 0;
+    disturbance.header.state = RECORDER_ARMED;
+    // The interrupt ignores everything until this last write
+    state = RECORDER_ARMED;
+}
+
+// Nothing is taken before the first cycle is in the ring, the phasors of a
+// sliding DFT are still filling their window then and pick up on the DC bias
+void recorderTrigger(recorderCause cause){
+    if(state == RECORDER_ARMED && history && trigger_request == RECORDER_CAUSE_NONE){
+        trigger_request = cause;
+    }
+}
+
+void recorderCycle(const uint16_t *raw, uint32_t period){
+    if(state == RECORDER_DONE){
+        return;
+    }
+
+    uint8_t cause = trigger_request;
+    if(cause != RECORDER_CAUSE_NONE && state == RECORDER_ARMED){
+        // Keep as many of the pre-trigger cycles as the ring still holds
+        uint16_t kept = history;
+        while(kept && head - block_start[(slot + HISTORY - kept) % HISTORY] > RECORDER_BYTES){
+            kept--;
+        }
+        record_start = kept ? block_start[(slot + HISTORY - kept) % HISTORY] : head;
+        disturbance.header.pre_cycles = kept;
+        disturbance.header.cause = cause;
+        post_left = RECORDER_POST_CYCLES;
+        state = RECORDER_TRIGGERED;
+    }
+
+    // One delta width per channel, the widest step of the cycle
+    uint8_t width[ADC_CHANNELS];
+    uint32_t payload = 0;
+    for(int ch = 0; ch < ADC_CHANNELS; ch++){
+        uint32_t spread = 0;
+        for(int i = 1; i < sample_times; i++){
+            spread |= zigzag((int32_t)raw[i * ADC_CHANNELS + ch] - raw[(i - 1) * ADC_CHANNELS + ch]);
+        }
+        width[ch] = spread ? 32 - __builtin_clz(spread) : 0;
+        payload += ADC_BITS + (sample_times - 1) * width[ch];
+    }
+    uint32_t length = RECORDER_BLOCK_HEADER + (ADC_CHANNELS + 1) / 2 + (payload + 7) / 8;
+
+    // Never overwrite the start of the record, a full ring cuts the post-trigger window short
+    if(state == RECORDER_TRIGGERED && head + length - record_start > RECORDER_BYTES){
+        freeze();
+        return;
+    }
+
+    block_start[slot] = head;
+    slot = (slot + 1) % HISTORY;
+    if(history < RECORDER_PRE_CYCLES){
+        history++;
+    }
+
+    if(period > UINT16_MAX){
+        period = UINT16_MAX;
+    }
+    bitWriter w = { .pos = head };
+    putBits(&w, length & 0xFF, 8);
+    putBits(&w, length >> 8, 8);
+    putBits(&w, period & 0xFF, 8);
+    putBits(&w, period >> 8, 8);
+    for(int ch = 0; ch < ADC_CHANNELS; ch++){
+        putBits(&w, width[ch], 4);
+    }
+    if(ADC_CHANNELS & 1){
+        putBits(&w, 0, 4);
+    }
+    for(int ch = 0; ch < ADC_CHANNELS; ch++){
+        putBits(&w, raw[ch], ADC_BITS);
+        if(!width[ch]){
+            continue;
+        }
+        for(int i = 1; i < sample_times; i++){
+            putBits(&w, zigzag((int32_t)raw[i * ADC_CHANNELS + ch] - raw[(i - 1) * ADC_CHANNELS + ch]), width[ch]);
+        }
+    }
+    // Flush the last partial byte
+    putBits(&w, 0, 7);
+    head += length;
+
+    if(state == RECORDER_TRIGGERED){
+        post_left--;
+        if(!post_left){
+            freeze();
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,109 @@
+#include "main.h"
+
+cpuLoad cpu_load;
+
+// One bit per schedulerTask, set by the interrupts and taken all at once by the loop
+static volatile uint32_t pending = 0;
+
+// Cycle counter when the core last woke up and what it has been awake since the last power cycle
+static uint32_t awake_since;
+static uint32_t busy_cycles;
+static uint32_t wakeups;
+
+// Core clock in cycles per microsecond, g_current_period is in microseconds
+static uint32_t cycles_per_us;
+
+#if RELAY_TRIP_ISR
+// What the protection interrupt runs, set when the loop starts
+static taskHandler protection_task;
+
+void schedulerProtection(void){
+    protection_task();
+}
+#endif
+
+#ifdef RELAY_HOST
+#include <time.h>
+
+// The simulation stands still while the firmware runs, the busy time is the wall
+// clock of the host scaled to the core clock, so only the proportions mean anything
+static uint32_t loadCount(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((uint64_t)now.tv_sec * SystemCoreClock + (uint64_t)now.tv_nsec * (SystemCoreClock / 1000000) / 1000);
+}
+#else
+#define loadCount() (DWT->CYCCNT)
+#endif
+
+void scheduler_init(void){
+#ifndef RELAY_HOST
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+    cycles_per_us = SystemCoreClock / 1000000;
+    awake_since = loadCount();
+#if RELAY_TRIP_ISR
+    // Posts before the loop starts stay pending until schedulerRun enables it
+    HAL_NVIC_SetPriority(PROTECTION_IRQn, PROTECTION_PRIORITY, 0);
+#endif
+}
+
+void schedulerPost(schedulerTask task){
+#if RELAY_TRIP_ISR
+    // Tail chained onto the posting interrupt, the loop never sees it
+    if(task == TASK_ACQUISITION){
+        HAL_NVIC_SetPendingIRQ(PROTECTION_IRQn);
+        return;
+    }
+#endif
+    // LDREX and STREX, an interrupt of a higher priority posting at the same time is not lost
+    __atomic_fetch_or(&pending, 1u << task, __ATOMIC_RELAXED);
+}
+
+void schedulerCycle(void){
+    uint32_t now = loadCount();
+    uint32_t busy = busy_cycles + (now - awake_since);
+    uint32_t budget = g_current_period * cycles_per_us;
+    awake_since = now;
+    busy_cycles = 0;
+
+    cpu_load.busy = busy;
+    cpu_load.idle = busy < budget ? budget - busy : 0;
+    cpu_load.load = busy < budget ? (uint16_t)((uint64_t)busy * 1000 / budget) : 1000;
+    if(cpu_load.load > cpu_load.peak){
+        cpu_load.peak = cpu_load.load;
+    }
+    if(busy >= budget){
+        cpu_load.overloads++;
+    }
+    cpu_load.wakeups = wakeups;
+    wakeups = 0;
+}
+
+void schedulerRun(const taskHandler tasks[TASK_COUNT]){
+#if RELAY_TRIP_ISR
+    protection_task = tasks[TASK_ACQUISITION];
+    HAL_NVIC_EnableIRQ(PROTECTION_IRQn);
+#endif
+    while(1){
+        // With PRIMASK set an interrupt still ends the WFI but its handler only runs
+        // once it is cleared, so a post between the check and the sleep is not slept through
+        __disable_irq();
+        uint32_t ready = __atomic_exchange_n(&pending, 0, __ATOMIC_RELAXED);
+        if(!ready){
+            busy_cycles += loadCount() - awake_since;
+            __WFI();
+            awake_since = loadCount();
+            wakeups++;
+        }
+        __enable_irq();
+
+        for(uint32_t task = 0; ready; task++){
+            if(ready & (1u << task)){
+                ready &= ~(1u << task);
+                tasks[task]();
+            }
+        }
+    }
+}
@@ -0,0 +1,150 @@
+#include "main.h"
+
+settingsStats settings_stats;
+
+// One bank per group and the spare a change is compiled into
+static compiledSettings banks[SETTING_GROUPS + 1];
+static compiledSettings *group_bank[SETTING_GROUPS];
+static compiledSettings *spare = &banks[SETTING_GROUPS];
+
+const compiledSettings *volatile active_settings = &banks[GROUP_NORMAL];
+
+static uint8_t active_group = GROUP_NORMAL;
+static volatile uint8_t selected_group = GROUP_NORMAL;
+
+// The group the spare bank holds a change for, -1 when it is free
+static int8_t waiting = -1;
+
+#if GROUP_INPUTS
+#define GROUP_PINS (((1u << GROUP_INPUTS) - 1) << 4)
+
+// The code last taken from the inputs and a new one waiting out the debounce
+static uint8_t input_code;
+static uint8_t new_code;
+static uint8_t new_cycles;
+
+// Contacts close to ground, a closed input is a 1
+static uint8_t readInputs(void){
+    uint8_t code = 0;
+    for(int bit = 0; bit < GROUP_INPUTS; bit++){
+        if(HAL_GPIO_ReadPin(GPIOB, (uint16_t)(GPIO_PIN_4 << bit)) == GPIO_PIN_RESET){
+            code |= 1u << bit;
+        }
+    }
+    return code;
+}
+
+static void groupInputsInit(void){
+    __HAL_RCC_GPIOB_CLK_ENABLE();
+    GPIO_InitTypeDef GPIO_InitStruct = {
+        .Pin = GROUP_PINS,
+        .Mode = GPIO_MODE_INPUT,
+        // Open contacts read as 0, the normal group
+        .Pull = GPIO_PULLUP,
+        .Speed = GPIO_SPEED_FREQ_LOW,
+    };
+    HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
+
+    input_code = readInputs();
+    new_code = input_code;
+    if(input_code < SETTING_GROUPS){
+        selected_group = input_code;
+    }
+}
+
+// A code that held for GROUP_DEBOUNCE cycles selects its group, a code past the last group is ignored
+static void followInputs(void){
+    uint8_t code = readInputs();
+    if(code != new_code){
+        new_code = code;
+        new_cycles = 0;
+    }
+    if(new_code == input_code){
+        return;
+    }
+    if(++new_cycles >= GROUP_DEBOUNCE){
+        input_code = new_code;
+        settingsSelect(input_code);
+    }
+}
+#else
+static inline void groupInputsInit(void){}
+
+static inline void followInputs(void){}
+#endif
+
+void settingsCompile(const relayType *relay, compiledSettings *out){
+    out->pickup = toPickup(relay->current_pickup);
+#ifdef ELEMENT_RESIDUAL
+    out->residual_pickup = toPickup(relay->residual_pickup);
+#endif
+    out->cos_angle = toTwiddle(cos(relay->direction_angle));
+    out->sin_angle = toTwiddle(sin(relay->direction_angle));
+    // Only the time dial is applied at run time, the curve itself is in flash
+    out->curve = curveRates[relay->type];
+    out->dial = toDial(CURVE_BASE_DELAY / relay->time_delay);
+    out->instant = instantCompile(relay->instant_pickup, relay->instant_count);
+    out->restraint = restraintCompile(relay->harmonic_restraint);
+}
+
+void settings_init(const relayType groups[SETTING_GROUPS]){
+    for(int g = 0; g < SETTING_GROUPS; g++){
+        group_bank[g] = &banks[g];
+        settingsCompile(&groups[g], group_bank[g]);
+    }
+    spare = &banks[SETTING_GROUPS];
+    waiting = -1;
+
+    groupInputsInit();
+    active_group = selected_group;
+    active_settings = group_bank[active_group];
+}
+
+bool settingsApply(uint8_t group, const relayType *relay){
+    if(group >= SETTING_GROUPS || waiting >= 0){
+        settings_stats.refused++;
+        return false;
+    }
+    settingsCompile(relay, spare);
+    waiting = (int8_t)group;
+    return true;
+}
+
+bool settingsSelect(uint8_t group){
+    if(group >= SETTING_GROUPS){
+        return false;
+    }
+    selected_group = group;
+    return true;
+}
+
+uint8_t settingsGroup(void){
+    return active_group;
+}
+
+void settingsCycle(void){
+    followInputs();
+
+    bool publish = false;
+    if(waiting >= 0){
+        // The spare takes the group's place and the old bank becomes the spare
+        compiledSettings *old = group_bank[waiting];
+        group_bank[waiting] = spare;
+        spare = old;
+        publish = waiting == active_group;
+        waiting = -1;
+        settings_stats.applied++;
+    }
+
+    uint8_t group = selected_group;
+    if(group != active_group){
+        active_group = group;
+        publish = true;
+        settings_stats.switches++;
+    }
+
+    // A single store, the ADC interrupt sees either bank whole
+    if(publish){
+        active_settings = group_bank[active_group];
+    }
+}
@@ -1,15 +1,54 @@
 #include "stm32f4xx_it.h"
+#include "relay_config.h"
+#include "scheduler.h"
+#include "latency.h"
 
 // ADC interrupt handler
 void ADC_IRQHandler(void)
 {
+#if RELAY_ACQ == RELAY_ACQ_DMA
+    // A scan is in the DMA buffer, only wake the main loop for it, to the HAL an EOC is a whole transfer
+    if(__HAL_ADC_GET_FLAG(&adc_handle, ADC_FLAG_EOC)){
+        __HAL_ADC_CLEAR_FLAG(&adc_handle, ADC_FLAG_EOC);
+        latencyScan();
+        schedulerPost(TASK_ACQUISITION);
+    }
+#endif
     HAL_ADC_IRQHandler(&adc_handle);
 }
 
-// TIM3 input capture interrupt handler
-void TIM3_IRQHandler(void)
+// TIM2 zero crossing capture interrupt handler
+void TIM2_IRQHandler(void)
 {
     HAL_TIM_IRQHandler(&zero_handle);
 }
 
+// ADC DMA half and full transfer handler
+void DMA2_Stream0_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&adc_dma_handle);
+}
+
+#if RELAY_TRIP_ISR
+// The DFT and the decisions, pended by the acquisition interrupts
+void EXTI0_IRQHandler(void)
+{
+    schedulerProtection();
+}
+#endif
+
+#if RELAY_TELEMETRY
+// Telemetry frame moved into the UART
+void DMA1_Stream6_IRQHandler(void)
+{
+    HAL_DMA_IRQHandler(&telemetry_dma);
+}
+
+// Telemetry frame left the wire
+void USART2_IRQHandler(void)
+{
+    HAL_UART_IRQHandler(&telemetry_uart);
+}
+#endif
+
 
@@ -0,0 +1,182 @@
+#include <string.h>
+
+#include "main.h"
+
+#if RELAY_TELEMETRY
+
+UART_HandleTypeDef telemetry_uart;
+DMA_HandleTypeDef telemetry_dma;
+
+volatile uint32_t telemetry_dropped = 0;
+
+// One frame on the wire, the other filled by the main loop or waiting for its turn
+static uint8_t frames[2][TELEMETRY_FRAME];
+static volatile int8_t on_wire = -1;    // Frame the DMA is sending, -1 when idle
+static volatile int8_t ready = -1;      // Complete frame waiting for the DMA, -1 when none
+static uint16_t sequence = 0;
+static uint32_t decisions = 0;
+
+static void startFrame(int8_t frame){
+    on_wire = frame;
+    HAL_UART_Transmit_DMA(&telemetry_uart, frames[frame], TELEMETRY_FRAME);
+}
+
+// The last byte left the shift register, send the next frame if one is waiting
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart){
+    if(huart != &telemetry_uart){
+        return;
+    }
+    int8_t next = ready;
+    ready = -1;
+    on_wire = -1;
+    if(next >= 0){
+        startFrame(next);
+    }
+}
+
+// USART2 TX on PA2 through DMA1 stream 6 channel 4, the RX pin is left alone
+void telemetry_init(void){
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+    __HAL_RCC_USART2_CLK_ENABLE();
+    __HAL_RCC_DMA1_CLK_ENABLE();
+
+    GPIO_InitTypeDef GPIO_InitStruct = {
+        .Pin = GPIO_PIN_2,
+        .Mode = GPIO_MODE_AF_PP,
+        .Pull = GPIO_PULLUP,
+        .Speed = GPIO_SPEED_FREQ_VERY_HIGH,
+        .Alternate = GPIO_AF7_USART2,
+    };
+    HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+
+    telemetry_dma.Instance = DMA1_Stream6;
+    telemetry_dma.Init.Channel = DMA_CHANNEL_4;
+    telemetry_dma.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    telemetry_dma.Init.PeriphInc = DMA_PINC_DISABLE;
+    telemetry_dma.Init.MemInc = DMA_MINC_ENABLE;
+    telemetry_dma.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    telemetry_dma.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    // One frame a transfer, the next one is started from the completion
+    telemetry_dma.Init.Mode = DMA_NORMAL;
+    // Never ahead of the ADC stream
+    telemetry_dma.Init.Priority = DMA_PRIORITY_LOW;
+    telemetry_dma.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+    HAL_DMA_Init(&telemetry_dma);
+
+    telemetry_uart.Instance = USART2;
+    telemetry_uart.Init.BaudRate = TELEMETRY_BAUD;
+    telemetry_uart.Init.WordLength = UART_WORDLENGTH_8B;
+    telemetry_uart.Init.StopBits = UART_STOPBITS_1;
+    telemetry_uart.Init.Parity = UART_PARITY_NONE;
+    telemetry_uart.Init.Mode = UART_MODE_TX;
+    telemetry_uart.Init.HwFlowCtl = UART_HWCONTROL_NONE;
+    telemetry_uart.Init.OverSampling = UART_OVERSAMPLING_16;
+    HAL_UART_Init(&telemetry_uart);
+
+    __HAL_LINKDMA(&telemetry_uart, hdmatx, telemetry_dma);
+
+    // Below the acquisition, a late frame only costs a later frame
+    HAL_NVIC_SetPriority(DMA1_Stream6_IRQn, 3, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Stream6_IRQn);
+    HAL_NVIC_SetPriority(USART2_IRQn, 3, 0);
+    HAL_NVIC_EnableIRQ(USART2_IRQn);
+}
+
+// Keep the completion out while the slots change hands
+static inline void lockTelemetry(void){
+    HAL_NVIC_DisableIRQ(USART2_IRQn);
+}
+
+static inline void unlockTelemetry(void){
+    HAL_NVIC_EnableIRQ(USART2_IRQn);
+}
+
+static inline uint8_t *putFloat(uint8_t *p, float value){
+    memcpy(p, &value, sizeof(value));
+    return p + sizeof(value);
+}
+
+// The units of the hot path back into volts and plain ratios
+static inline float phasorVolts(phasor_t value){
+    return (float)(value / PHASOR_PER_VOLT);
+}
+
+static inline float psm2Value(psm2_t psm2){
+#if RELAY_NUMERIC == RELAY_NUMERIC_FIXED
+    return (float)psm2 / 65536.0f;
+#else
+    return (float)psm2;
+#endif
+}
+
+static inline float progressFraction(progress_t progress){
+    return (float)((double)progress / (double)PROGRESS_TRIP);
+}
+
+void telemetryDecision(const complexNum *phasors, const elementStatus *elements, bool tripped, bool forward){
+    // One frame a cycle, a sliding DFT decides every sample
+    if(++decisions < decision_times){
+        return;
+    }
+    decisions = 0;
+
+    // Whichever buffer is not on the wire, a frame still waiting in it is replaced
+    lockTelemetry();
+    int8_t fill = on_wire == 0 ? 1 : 0;
+    if(ready >= 0){
+        ready = -1;
+        telemetry_dropped++;
+    }
+    unlockTelemetry();
+
+    uint8_t *frame = frames[fill];
+    uint8_t *p = frame;
+    *p++ = TELEMETRY_SYNC0;
+    *p++ = TELEMETRY_SYNC1;
+    *p++ = TELEMETRY_VERSION;
+    *p++ = TELEMETRY_PAYLOAD;
+    *p++ = (uint8_t)sequence;
+    *p++ = (uint8_t)(sequence >> 8);
+    sequence++;
+
+    uint32_t period = g_current_period;
+    memcpy(p, &period, sizeof(period));
+    p += sizeof(period);
+    *p++ = ADC_CHANNELS;
+    *p++ = RELAY_ELEMENTS;
+    *p++ = (tripped ? TELEMETRY_TRIPPED : 0) | (forward ? TELEMETRY_FORWARD : 0) | (instantActive() ? TELEMETRY_INSTANT : 0)
+        | (harmonicRestrained() ? TELEMETRY_RESTRAINED : 0) | (settingsGroup() << TELEMETRY_GROUP_SHIFT);
+    *p++ = freq_tracker.source;
+    *p++ = (uint8_t)cpu_load.load;
+    *p++ = (uint8_t)(cpu_load.load >> 8);
+    uint32_t worst = latencyTripWorst();
+    uint16_t trip_latency = worst > UINT16_MAX ? UINT16_MAX : (uint16_t)worst;
+    *p++ = (uint8_t)trip_latency;
+    *p++ = (uint8_t)(trip_latency >> 8);
+
+    for(int ch = 0; ch < ADC_CHANNELS; ch++){
+        p = putFloat(p, phasorVolts(phasors[ch].real));
+        p = putFloat(p, phasorVolts(phasors[ch].img));
+    }
+    for(int e = 0; e < RELAY_ELEMENTS; e++){
+        p = putFloat(p, psm2Value(elements[e].psm2));
+        p = putFloat(p, progressFraction(elements[e].progress));
+    }
+    for(int e = 0; e < RELAY_ELEMENTS; e++){
+        *p++ = elements[e].flags;
+    }
+
+    uint16_t crc = telemetryCrc(frame + 2, TELEMETRY_HEADER - 2 + TELEMETRY_PAYLOAD);
+    *p++ = (uint8_t)crc;
+    *p++ = (uint8_t)(crc >> 8);
+
+    lockTelemetry();
+    if(on_wire < 0){
+        startFrame(fill);
+    } else {
+        ready = fill;
+    }
+    unlockTelemetry();
+}
+
+#endif